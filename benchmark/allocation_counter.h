@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+// Counts heap allocations of the whole program for the host benchmarks. Replaces the global
+// operator new and delete, so it must be included into exactly one translation unit: the
+// benchmark's own source file.
+namespace esphome
+{
+  namespace bl0910
+  {
+    inline std::atomic<uint32_t> &allocation_counter()
+    {
+      static std::atomic<uint32_t> count{0};
+      return count;
+    }
+
+    // Allocations since boot
+    inline uint32_t allocation_count() { return allocation_counter().load(std::memory_order_relaxed); }
+
+    inline void *counted_allocate(std::size_t size)
+    {
+      allocation_counter().fetch_add(1, std::memory_order_relaxed);
+      void *block = std::malloc(size == 0 ? 1 : size);
+      if (block == nullptr)
+      {
+        // The firmware is built without relying on exceptions, fail the run instead
+        std::abort();
+      }
+      return block;
+    }
+
+  } // namespace bl0910
+} // namespace esphome
+
+void *operator new(std::size_t size) { return esphome::bl0910::counted_allocate(size); }
+void *operator new[](std::size_t size) { return esphome::bl0910::counted_allocate(size); }
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept { return esphome::bl0910::counted_allocate(size); }
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept { return esphome::bl0910::counted_allocate(size); }
+void operator delete(void *block) noexcept { std::free(block); }
+void operator delete[](void *block) noexcept { std::free(block); }
+void operator delete(void *block, std::size_t) noexcept { std::free(block); }
+void operator delete[](void *block, std::size_t) noexcept { std::free(block); }
+void operator delete(void *block, const std::nothrow_t &) noexcept { std::free(block); }
+void operator delete[](void *block, const std::nothrow_t &) noexcept { std::free(block); }
@@ -0,0 +1,111 @@
+// Harmonic analysis of waveform.h against synthetic waveforms with known harmonic content: the
+// error of THD and of each harmonic, and the time one segment takes to analyse. Prints one BENCH
+// line per case. Built and checked against its baselines by benchmark/run.py.
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "waveform.h"
+
+using namespace esphome::bl0910;
+
+namespace
+{
+  struct Case
+  {
+    const char *name;
+    float sample_rate;
+    float fundamental;
+    uint16_t samples;
+    double amplitude; // LSB, the waveform registers are 24 bits
+    uint32_t noise;   // +/- LSB
+    // Amplitude of each order relative to the fundamental, [0] and [1] unused
+    const float *harmonics;
+  };
+
+  constexpr float PURE[WAVEFORM_MAX_HARMONIC + 1] = {};
+  constexpr float H3_H5[WAVEFORM_MAX_HARMONIC + 1] = {0, 0, 0, 0.2f, 0, 0.1f};
+  // Odd harmonics at 1/n, as in a square wave
+  constexpr float SQUARE[WAVEFORM_MAX_HARMONIC + 1] = {0, 0, 0, 1 / 3.0f, 0, 1 / 5.0f, 0, 1 / 7.0f, 0, 1 / 9.0f,
+                                                       0, 1 / 11.0f, 0, 1 / 13.0f, 0, 1 / 15.0f};
+
+  const Case CASES[] = {
+      {"sine", 5000, 50.0f, 256, 4e6, 0, PURE},
+      {"h3_h5", 5000, 50.0f, 256, 4e6, 0, H3_H5},
+      {"off_nominal", 5000, 49.7f, 256, 4e6, 0, H3_H5},
+      {"noisy", 5000, 50.0f, 256, 4e6, 20000, H3_H5},
+      {"small", 5000, 50.0f, 256, 300, 0, H3_H5},
+      {"square_60hz", 10000, 60.0f, 1024, 6e6, 0, SQUARE},
+      {"long", 20000, 50.0f, 2048, 8e6, 0, SQUARE},
+  };
+
+  // Same sequence on every run
+  uint32_t next_random(uint32_t &state)
+  {
+    state = state * 1664525u + 1013904223u;
+    return state >> 8;
+  }
+
+  void fill(const Case &c, WaveformRing &ring, int segment)
+  {
+    uint32_t random = 12345 + segment;
+    ring.clear();
+    for (uint16_t i = 0; i < c.samples; i++)
+    {
+      double w = 2 * M_PI * c.fundamental * (i + segment * 17) / c.sample_rate;
+      double value = std::sin(w);
+      for (uint8_t order = 2; order <= WAVEFORM_MAX_HARMONIC; order++)
+      {
+        value += c.harmonics[order] * std::sin(order * w + 0.3 * order);
+      }
+      int32_t noise = c.noise == 0 ? 0 : (int32_t) (next_random(random) % (2 * c.noise + 1)) - (int32_t) c.noise;
+      ring.push((int32_t) std::lround(c.amplitude * value) + 1000 + noise);
+    }
+  }
+} // namespace
+
+int main()
+{
+  const int segments = 4;
+  const int timing_runs = 200;
+  for (const Case &c : CASES)
+  {
+    std::vector<int32_t> storage(c.samples);
+    WaveformRing ring;
+    ring.attach(storage.data(), c.samples);
+    HarmonicAnalyzer analyzer;
+    analyzer.reset();
+    for (int segment = 0; segment < segments; segment++)
+    {
+      fill(c, ring, segment);
+      analyzer.add(ring, c.sample_rate, c.fundamental, WAVEFORM_MAX_HARMONIC);
+    }
+    HarmonicResult result = analyzer.result();
+
+    double distortion = 0;
+    double harmonic_error = 0;
+    for (uint8_t order = 2; order <= result.count; order++)
+    {
+      distortion += c.harmonics[order] * c.harmonics[order];
+      harmonic_error = std::fmax(harmonic_error, std::fabs(result.relative(order) - c.harmonics[order]));
+    }
+    double thd_error = std::fabs(result.thd - std::sqrt(distortion));
+
+    // Time one segment's analysis, the samples are already in the ring
+    HarmonicAnalyzer timed;
+    auto start = std::chrono::steady_clock::now();
+    for (int run = 0; run < timing_runs; run++)
+    {
+      timed.reset();
+      timed.add(ring, c.sample_rate, c.fundamental, WAVEFORM_MAX_HARMONIC);
+    }
+    double elapsed_ns =
+        std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / timing_runs;
+
+    // Errors in hundredths of a percent point of the fundamental
+    printf("BENCH case=%s samples=%u orders=%u thd_error=%ld harmonic_error=%ld segment_ns=%ld\n", c.name, c.samples,
+           result.count, std::lround(thd_error * 1e4), std::lround(harmonic_error * 1e4), std::lround(elapsed_ns));
+  }
+  return 0;
+}
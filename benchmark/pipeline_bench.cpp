@@ -0,0 +1,235 @@
+// Polling pipeline on the host: emulated chips with all 10 channels and every sensor, driven by
+// update() and loop() as ESPHome's main loop drives them. Prints one BENCH line per scenario.
+// Built against the stand-in ESPHome headers by benchmark/run.py.
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "allocation_counter.h"
+#include "bl0910.h"
+#include "hub.h"
+
+using namespace esphome;
+using namespace esphome::bl0910;
+
+namespace
+{
+  // 8N1 at 19200 baud
+  const uint32_t UART_BYTE_TIME_US = 10 * 1000000 / 19200;
+  const int WARMUP_SWEEPS = 2;
+  const int MEASURED_SWEEPS = 20;
+  // loop() calls timed at most per scenario, reserved up front so timing them allocates nothing
+  const size_t MAX_LOOP_CALLS = 4000000;
+
+  struct Scenario
+  {
+    const char *name;
+    uint8_t chips;
+    bool spi;
+    bool hub;
+    // Each sweep also packed into a telemetry frame and handed to an on_frame trigger
+    bool telemetry;
+  };
+
+  const Scenario SCENARIOS[] = {
+      {"uart-1", 1, false, false, false},
+      {"spi-1", 1, true, false, false},
+      {"spi-1-telemetry", 1, true, false, true},
+      {"hub-4", 4, true, true, false},
+      {"hub-8", 8, true, true, false},
+  };
+
+  struct Counters
+  {
+    uint64_t frames{0};
+    uint64_t bytes{0};
+    uint32_t publishes{0};
+    uint32_t errors{0};
+    uint32_t allocations{0};
+  };
+
+  template <typename Chip> void configure(Chip &chip, std::vector<sensor::Sensor> &sensors, bool spi)
+  {
+    EmulatorConfig config{};
+    config.noise_lsb = 0;
+    config.byte_time_us = spi ? 0 : UART_BYTE_TIME_US;
+    chip.set_emulator_config(config);
+    chip.set_restore_energy(false);
+    size_t next = sensors.size() - 5 - BL0910_CHANNEL_COUNT * 5;
+    chip.set_voltage_sensor(&sensors[next++]);
+    chip.set_frequency_sensor(&sensors[next++]);
+    chip.set_temperature_sensor(&sensors[next++]);
+    chip.set_total_power_sensor(&sensors[next++]);
+    chip.set_total_energy_sensor(&sensors[next++]);
+    for (uint8_t channel = 1; channel <= BL0910_CHANNEL_COUNT; channel++)
+    {
+      for (ChannelSlot slot : {ChannelSlot::CURRENT, ChannelSlot::POWER, ChannelSlot::ENERGY, ChannelSlot::POWER_FACTOR,
+                               ChannelSlot::APPARENT_POWER})
+      {
+        chip.set_channel_sensor(channel, slot, &sensors[next++]);
+      }
+    }
+  }
+
+  Counters snapshot(const std::vector<BL0910 *> &chips)
+  {
+    Counters counters;
+    for (BL0910 *chip : chips)
+    {
+      const BusDiagnostics &diagnostics = chip->get_diagnostics();
+      counters.frames += diagnostics.frames;
+      counters.bytes += diagnostics.bytes;
+      counters.errors += diagnostics.checksum_errors + diagnostics.timeouts;
+      counters.publishes += chip->get_publish_count();
+    }
+    counters.allocations = allocation_count();
+    return counters;
+  }
+
+  template <typename T> T median(std::vector<T> values)
+  {
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+  }
+
+  template <typename Chip> void run(const Scenario &scenario)
+  {
+    std::vector<std::unique_ptr<Chip>> devices;
+    std::vector<BL0910 *> chips;
+    std::vector<sensor::Sensor> sensors;
+    sensors.reserve(scenario.chips * (5 + BL0910_CHANNEL_COUNT * 5));
+    BL0910Hub hub;
+    std::vector<std::unique_ptr<TelemetryTrigger>> triggers;
+    // Frames are checked, as a receiver would, so that none is optimised away
+    uint32_t frames_received = 0;
+    for (uint8_t i = 0; i < scenario.chips; i++)
+    {
+      sensors.resize(sensors.size() + 5 + BL0910_CHANNEL_COUNT * 5);
+      devices.emplace_back(new Chip());
+      configure(*devices.back(), sensors, scenario.spi);
+      chips.push_back(devices.back().get());
+      if (scenario.telemetry)
+      {
+        devices.back()->set_telemetry_chip(i);
+        triggers.emplace_back(new TelemetryTrigger(devices.back().get()));
+        triggers.back()->add([&frames_received](const uint8_t *data, size_t size) {
+          frames_received += TelemetryFrame::valid(data, size);
+        });
+      }
+      if (scenario.hub)
+      {
+        hub.register_chip(devices.back().get(), 0);
+      }
+    }
+    for (auto &device : devices)
+    {
+      device->setup();
+    }
+    if (scenario.hub)
+    {
+      hub.setup();
+    }
+
+    // Each sweep starts with update() and runs loop() until it is complete, as the scheduler does
+    // with an update interval longer than a sweep
+    auto sweeps_done = [&]() -> uint32_t {
+      return scenario.hub ? hub.get_sweep_count() : chips[0]->get_diagnostics().sweeps;
+    };
+    auto sweep_time = [&]() -> uint32_t {
+      return scenario.hub ? hub.get_last_sweep_us() : chips[0]->get_diagnostics().last_sweep_us;
+    };
+    std::vector<uint32_t> loop_times;
+    loop_times.reserve(MAX_LOOP_CALLS);
+    std::vector<uint32_t> sweep_times;
+    std::vector<uint32_t> sweep_max_loop;
+    sweep_times.reserve(MEASURED_SWEEPS);
+    sweep_max_loop.reserve(MEASURED_SWEEPS);
+    Counters first;
+    for (int sweep = 0; sweep < WARMUP_SWEEPS + MEASURED_SWEEPS; sweep++)
+    {
+      bool measured = sweep >= WARMUP_SWEEPS;
+      if (sweep == WARMUP_SWEEPS)
+      {
+        first = snapshot(chips);
+      }
+      uint32_t target = sweeps_done() + 1;
+      if (scenario.hub)
+      {
+        hub.update();
+      }
+      else
+      {
+        chips[0]->update();
+      }
+      uint32_t longest = 0;
+      while (sweeps_done() < target)
+      {
+        uint32_t start = micros();
+        if (scenario.hub)
+        {
+          hub.loop();
+        }
+        for (auto &device : devices)
+        {
+          device->loop();
+        }
+        uint32_t elapsed = micros() - start;
+        longest = std::max(longest, elapsed);
+        if (measured && loop_times.size() < loop_times.capacity())
+        {
+          loop_times.push_back(elapsed);
+        }
+      }
+      if (measured)
+      {
+        sweep_times.push_back(sweep_time());
+        sweep_max_loop.push_back(longest);
+      }
+    }
+    Counters last = snapshot(chips);
+    if (scenario.telemetry && frames_received != (uint32_t) (WARMUP_SWEEPS + MEASURED_SWEEPS) * scenario.chips)
+    {
+      fprintf(stderr, "%s: %u telemetry frames received\n", scenario.name, frames_received);
+      exit(1);
+    }
+
+    std::sort(loop_times.begin(), loop_times.end());
+    uint32_t loop_p99 = loop_times[loop_times.size() * 99 / 100];
+    double sweeps = MEASURED_SWEEPS;
+    printf("BENCH scenario=%s sweep_us=%u loop_p99_us=%u loop_max_us=%u frames_per_sweep=%.2f "
+           "bytes_per_sweep=%.2f publishes_per_sweep=%.2f errors_per_sweep=%.2f allocations_per_sweep=%.2f\n",
+           scenario.name, median(sweep_times), loop_p99, median(sweep_max_loop), (last.frames - first.frames) / sweeps,
+           (last.bytes - first.bytes) / sweeps, (last.publishes - first.publishes) / sweeps,
+           (last.errors - first.errors) / sweeps, (last.allocations - first.allocations) / sweeps);
+    fflush(stdout);
+  }
+} // namespace
+
+// Scenario names to run, all of them without any
+int main(int argc, char **argv)
+{
+  for (const Scenario &scenario : SCENARIOS)
+  {
+    bool selected = argc == 1;
+    for (int i = 1; i < argc; i++)
+    {
+      selected |= strcmp(argv[i], scenario.name) == 0;
+    }
+    if (!selected)
+    {
+      continue;
+    }
+    if (scenario.spi)
+    {
+      run<BL0910EmulatedSPI>(scenario);
+    }
+    else
+    {
+      run<BL0910EmulatedUART>(scenario);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,183 @@
+#!/usr/bin/env python3
+"""Build and run the BL0910 host benchmarks, and check them against stored baselines.
+
+The benchmarks build with the host compiler against the stand-in ESPHome headers in
+tests/stubs. Each prints one BENCH line per scenario or case:
+
+pipeline_bench.cpp: emulated chips with all 10 channels and every sensor, driven by update()
+and loop() like the main loop drives them. Scenarios: one UART chip at 19200 baud, one SPI chip
+at 1 MHz, the same SPI chip sending a telemetry frame per sweep, and hubs of 4 and 8 SPI chips.
+
+    sweep_us               first read to last reply of a sweep, median over the sweeps
+    loop_p99_us            99th percentile of the time one loop() call blocks
+    loop_max_us            longest loop() call of a sweep, median over the sweeps
+    frames_per_sweep       frames on the bus, reads and writes
+    bytes_per_sweep        bytes on the wire, both directions
+    publishes_per_sweep    sensor states published
+    errors_per_sweep       checksum errors and timeouts
+    allocations_per_sweep  heap allocations
+
+goertzel_bench.cpp: the harmonic analysis of waveform.h on synthetic waveforms.
+
+    samples                samples per segment
+    orders                 harmonic orders analysed
+    thd_error              THD error, in hundredths of a percent point of the fundamental
+    harmonic_error         largest harmonic error, same unit
+    segment_ns             time to analyse one segment
+
+Every benchmark runs --runs times and each metric is the median of the runs. A count that
+differs from its baseline, a time or error above its baseline by more than its tolerance, a
+metric without a baseline and a baseline that is not measured all fail the run.
+--update-baselines stores the measured values instead. Times depend on the machine: record
+them on the machine that runs the benchmarks.
+
+    python3 benchmark/run.py
+    python3 benchmark/run.py hub-8 sine --runs 5
+    python3 benchmark/run.py --update-baselines
+"""
+
+import argparse
+import json
+import os
+import re
+import statistics
+import subprocess
+import sys
+from pathlib import Path
+
+HERE = Path(__file__).resolve().parent
+ROOT = HERE.parent
+COMPONENT = ROOT / "custom_components" / "bl0910"
+BASELINES = HERE / "baselines.json"
+BUILD = HERE / "build"
+
+# name: (source, component sources linked in, key of the BENCH line naming the scenario)
+BENCHMARKS = {
+    "pipeline": ("pipeline_bench.cpp", ["bl0910.cpp", "hub.cpp"], "scenario"),
+    "goertzel": ("goertzel_bench.cpp", [], "case"),
+}
+FLAGS = ["-std=gnu++17", "-O2", "-DESPHOME_LOG_LEVEL=ESPHOME_LOG_LEVEL_WARN"]
+
+# metric: (relative tolerance, absolute slack), a value fails above baseline * (1 + relative) + slack.
+# EXACT metrics are deterministic counts and fail on any change, a drop in frames or publishes is as
+# much a regression as a rise: lost readings.
+EXACT = None
+METRICS = {
+    "sweep_us": (0.10, 100),
+    "loop_p99_us": (0.50, 300),
+    "loop_max_us": (0.50, 300),
+    "frames_per_sweep": EXACT,
+    "bytes_per_sweep": EXACT,
+    "publishes_per_sweep": EXACT,
+    "errors_per_sweep": EXACT,
+    "allocations_per_sweep": EXACT,
+    "samples": EXACT,
+    "orders": EXACT,
+    "thd_error": (0.0, 2),
+    "harmonic_error": (0.0, 2),
+    "segment_ns": (0.50, 2000),
+}
+
+BENCH_LINE = re.compile(r"^BENCH (.*)$")
+
+
+def build(benchmark, compiler):
+    source, sources, _ = BENCHMARKS[benchmark]
+    binary = BUILD / benchmark
+    BUILD.mkdir(exist_ok=True)
+    command = [compiler, *FLAGS, f"-I{ROOT / 'tests' / 'stubs'}", f"-I{COMPONENT}", f"-I{HERE}", str(HERE / source),
+               *(str(COMPONENT / name) for name in sources), "-o", str(binary)]
+    subprocess.run(command, check=True)
+    return binary
+
+
+def run(benchmark, binary, runs):
+    """Median of each metric over the runs, per scenario."""
+    key = BENCHMARKS[benchmark][2]
+    samples = {}
+    for _ in range(runs):
+        output = subprocess.run([str(binary)], check=True, capture_output=True, text=True).stdout
+        for line in output.splitlines():
+            if match := BENCH_LINE.match(line):
+                fields = dict(field.split("=", 1) for field in match.group(1).split())
+                name = fields.pop(key)
+                for metric, value in fields.items():
+                    samples.setdefault(name, {}).setdefault(metric, []).append(float(value))
+    return {name: {metric: statistics.median(values) for metric, values in metrics.items()}
+            for name, metrics in samples.items()}
+
+
+def compare(benchmark, name, metrics, baselines):
+    """Print the metrics of a scenario against their baselines, returns the number of failures."""
+    failures = 0
+    stored = baselines.get(benchmark, {}).get(name, {})
+    print(f"{benchmark} {name}:")
+    for metric, value in metrics.items():
+        baseline = stored.get(metric)
+        if baseline is None:
+            print(f"  {metric:24} {value:12.2f}  NO BASELINE")
+            failures += 1
+            continue
+        if METRICS[metric] is EXACT:
+            passed = abs(value - baseline) < 0.005
+            bound = "exact"
+        else:
+            relative, slack = METRICS[metric]
+            limit = baseline * (1 + relative) + slack
+            passed = value <= limit
+            bound = f"limit {limit:10.2f}"
+        failures += not passed
+        print(f"  {metric:24} {value:12.2f}  baseline {baseline:10.2f}  {bound:16}  {'ok' if passed else 'REGRESSION'}")
+    for metric in stored.keys() - metrics.keys():
+        print(f"  {metric:24} {'':12}  baseline {stored[metric]:10.2f}  NOT REPORTED")
+        failures += 1
+    return failures
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("names", nargs="*", help="scenarios and cases to check, default: all")
+    parser.add_argument("--runs", type=int, default=3, help="runs per benchmark, metrics are their median")
+    parser.add_argument("--update-baselines", action="store_true", help="store the measured values")
+    parser.add_argument("--cxx", default=os.environ.get("CXX", "g++"))
+    args = parser.parse_args()
+
+    baselines = json.loads(BASELINES.read_text()) if BASELINES.exists() else {}
+    failures = 0
+    checked = 0
+    for benchmark in BENCHMARKS:
+        results = run(benchmark, build(benchmark, args.cxx), args.runs)
+        if not args.update_baselines:
+            for name in baselines.get(benchmark, {}).keys() - results.keys():
+                if not args.names or name in args.names:
+                    print(f"{benchmark} {name}: has a baseline but did not run")
+                    failures += 1
+        for name, metrics in results.items():
+            if args.names and name not in args.names:
+                continue
+            unknown = set(metrics) - set(METRICS)
+            if unknown:
+                raise RuntimeError(f"no tolerance for {', '.join(sorted(unknown))}")
+            checked += 1
+            if args.update_baselines:
+                baselines.setdefault(benchmark, {})[name] = {metric: round(value, 2) for metric, value in metrics.items()}
+                print(f"{benchmark} {name}: " + " ".join(f"{metric}={value:g}" for metric, value in metrics.items()))
+            else:
+                failures += compare(benchmark, name, metrics, baselines)
+    if checked == 0:
+        print(f"no scenario or case named {', '.join(args.names)}")
+        return 1
+
+    if args.update_baselines:
+        BASELINES.write_text(json.dumps(baselines, indent=2) + "\n")
+        print(f"baselines written to {BASELINES}")
+        return 0
+    if failures:
+        print(f"{failures} checks failed")
+        return 1
+    print(f"{checked} scenarios within their baselines")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -1,10 +1,12 @@
+import re
 from esphome import automation
 from esphome.automation import maybe_simple_id
 import esphome.codegen as cg
+from esphome.core import CORE
 from esphome.components import sensor, uart, spi
 import esphome.config_validation as cv
 from esphome.const import (
-    CONF_CHANNEL, CONF_CURRENT, CONF_ENERGY, CONF_FREQUENCY, CONF_ID, CONF_NAME, CONF_POWER, CONF_TEMPERATURE, CONF_TOTAL_POWER, CONF_VOLTAGE, CONF_POWER_FACTOR, DEVICE_CLASS_CURRENT, DEVICE_CLASS_ENERGY, DEVICE_CLASS_FREQUENCY, DEVICE_CLASS_POWER, DEVICE_CLASS_TEMPERATURE, DEVICE_CLASS_VOLTAGE, DEVICE_CLASS_POWER_FACTOR, ICON_CURRENT_AC, ICON_THERMOMETER, STATE_CLASS_MEASUREMENT, STATE_CLASS_TOTAL_INCREASING, UNIT_AMPERE, UNIT_CELSIUS, UNIT_HERTZ, UNIT_KILOWATT_HOURS, UNIT_VOLT, UNIT_WATT, CONF_CS_PIN, CONF_MODE,
+    CONF_CHANNEL, CONF_TRIGGER_ID, CONF_CURRENT, CONF_ENERGY, CONF_FREQUENCY, CONF_ID, CONF_NAME, CONF_POWER, CONF_TEMPERATURE, CONF_TOTAL_POWER, CONF_VOLTAGE, CONF_POWER_FACTOR, DEVICE_CLASS_CURRENT, DEVICE_CLASS_ENERGY, DEVICE_CLASS_FREQUENCY, DEVICE_CLASS_POWER, DEVICE_CLASS_TEMPERATURE, DEVICE_CLASS_VOLTAGE, DEVICE_CLASS_POWER_FACTOR, ICON_CURRENT_AC, ICON_THERMOMETER, STATE_CLASS_MEASUREMENT, STATE_CLASS_TOTAL_INCREASING, UNIT_AMPERE, UNIT_CELSIUS, UNIT_HERTZ, UNIT_KILOWATT_HOURS, UNIT_VOLT, UNIT_WATT, CONF_CS_PIN, CONF_MODE, CONF_BAUD_RATE, UNIT_MILLISECOND, ENTITY_CATEGORY_DIAGNOSTIC, ICON_TIMER, CONF_APPARENT_POWER, DEVICE_CLASS_APPARENT_POWER, UNIT_VOLT_AMPS, UNIT_PERCENT, CONF_ADDRESS, CONF_VALUE, CONF_INTERVAL, CONF_DATA_RATE,
 )
 
 # Custom icons
@@ -13,6 +15,10 @@ ICON_ENERGY = "mdi:lightning-bolt"
 ICON_FREQUENCY = "mdi:metronome"
 ICON_VOLTAGE = "mdi:sine-wave"
 ICON_POWER_FACTOR = "mdi:angle-acute"
+ICON_HARMONICS = "mdi:waveform"
+ICON_COUNTER = "mdi:counter"
+ICON_BUS_ERROR = "mdi:alert-circle-outline"
+ICON_DATA_RATE = "mdi:speedometer"
 
 # Depends on UART or SPI components based on the mode
 MULTI_CONF = True
@@ -24,13 +30,89 @@ CONF_TOTAL_ENERGY = "total_energy"
 CONF_COMMUNICATION_MODE = "communication_mode"
 CONF_MODE_UART = "uart"
 CONF_MODE_SPI = "spi"
+CONF_LOOP_BUDGET = "loop_budget"
+CONF_PIPELINE_DEPTH = "pipeline_depth"
+CONF_RETRY_BUDGET = "retry_budget"
+CONF_SPI_BURST = "spi_burst"
+CONF_MODE_HUB = "hub"
+CONF_HUB_ID = "hub_id"
+CONF_PHASE = "phase"
+CONF_SHARE_LINE_READINGS = "share_line_readings"
+CONF_SWEEP_DURATION = "sweep_duration"
+CONF_MODE_EMULATOR = "emulator"
+CONF_EMULATED_INTERFACE = "emulated_interface"
+CONF_NOISE = "noise"
+CONF_REPLY_LATENCY = "reply_latency"
+CONF_CORRUPTION_RATE = "corruption_rate"
+CONF_SEED = "seed"
+CONF_SNAPSHOT_SAMPLING = "snapshot_sampling"
+CONF_MIN_APPARENT_POWER = "min_apparent_power"
+CONF_RESTORE_ENERGY = "restore_energy"
+CONF_ENERGY_SAVE_THRESHOLD = "energy_save_threshold"
+CONF_ENERGY_SAVE_INTERVAL = "energy_save_interval"
+CONF_STATISTICS_WINDOW = "statistics_window"
+CONF_DEADBAND = "deadband"
+CONF_ADAPTIVE_POLLING = "adaptive_polling"
+CONF_OVERCURRENT = "overcurrent"
+CONF_OVERPOWER = "overpower"
+CONF_THRESHOLD = "threshold"
+CONF_HYSTERESIS = "hysteresis"
+CONF_WATCH_INTERVAL = "watch_interval"
+CONF_ON_OVERCURRENT = "on_overcurrent"
+CONF_ON_OVERPOWER = "on_overpower"
+CONF_MAX_STALENESS = "max_staleness"
+CONF_CHANGE_THRESHOLD = "change_threshold"
+CONF_MAX_READS_PER_UPDATE = "max_reads_per_update"
+CONF_DEADBAND_PERCENT = "deadband_percent"
+CONF_MIN_PUBLISH_INTERVAL = "min_publish_interval"
+CONF_MAX_PUBLISH_INTERVAL = "max_publish_interval"
+CONF_WAVEFORM = "waveform"
+CONF_CAPTURE_INTERVAL = "capture_interval"
+CONF_SAMPLES = "samples"
+CONF_SAMPLE_INTERVAL = "sample_interval"
+CONF_SEGMENTS = "segments"
+CONF_MAX_HARMONIC = "max_harmonic"
+CONF_THD = "thd"
+CONF_HARMONIC = "harmonic"
+CONF_REFERENCE = "reference"
+CONF_QUANTITY = "quantity"
+CONF_VERIFY_INTERVAL = "verify_interval"
+CONF_DIAGNOSTICS = "diagnostics"
+CONF_DATA_RATE_TUNING = "data_rate_tuning"
+CONF_MIN_DATA_RATE = "min_data_rate"
+CONF_MAX_DATA_RATE = "max_data_rate"
+CONF_MAX_ERROR_RATE = "max_error_rate"
+CONF_CLEAN_DATA_RATE = "clean_data_rate"
+CONF_TELEMETRY = "telemetry"
+CONF_CHIP = "chip"
+CONF_ON_FRAME = "on_frame"
+CONF_TRACE = "trace"
+CONF_CAPACITY = "capacity"
+CONF_REPLAY = "replay"
 
 # Define namespace and classes
 bl0910_ns = cg.esphome_ns.namespace("bl0910")
 BL0910 = bl0910_ns.class_("BL0910", cg.PollingComponent)
 BL0910UART = bl0910_ns.class_("BL0910UART", BL0910, uart.UARTDevice)
 BL0910SPI = bl0910_ns.class_("BL0910SPI", BL0910, spi.SPIDevice)
+BL0910EmulatedUART = bl0910_ns.class_("BL0910EmulatedUART", BL0910)
+BL0910EmulatedSPI = bl0910_ns.class_("BL0910EmulatedSPI", BL0910)
+BL0910Hub = bl0910_ns.class_("BL0910Hub", cg.PollingComponent)
+EmulatorConfig = bl0910_ns.struct("EmulatorConfig")
+ChannelSlot = bl0910_ns.enum("ChannelSlot", is_class=True)
+StatKind = bl0910_ns.enum("StatKind", is_class=True)
+SensorSlot = bl0910_ns.enum("SensorSlot", is_class=True)
+PublishPolicy = bl0910_ns.struct("PublishPolicy")
 ResetEnergyAction = bl0910_ns.class_("ResetEnergyAction", automation.Action)
+CalibrateAction = bl0910_ns.class_("CalibrateAction", automation.Action)
+WriteRegisterAction = bl0910_ns.class_("WriteRegisterAction", automation.Action)
+CaptureWaveformAction = bl0910_ns.class_("CaptureWaveformAction", automation.Action)
+DumpTraceAction = bl0910_ns.class_("DumpTraceAction", automation.Action)
+CalibrationKind = bl0910_ns.enum("CalibrationKind", is_class=True)
+DiagnosticSlot = bl0910_ns.enum("DiagnosticSlot", is_class=True)
+OvercurrentTrigger = bl0910_ns.class_("OvercurrentTrigger", automation.Trigger.template(cg.uint8, cg.float_))
+OverpowerTrigger = bl0910_ns.class_("OverpowerTrigger", automation.Trigger.template(cg.uint8, cg.float_))
+TelemetryTrigger = bl0910_ns.class_("TelemetryTrigger", automation.Trigger.template(cg.uint8.operator("const").operator("ptr"), cg.size_t))
 
 # Sensor schema creation helper
 def create_sensor_schema(icon, accuracy_decimals, device_class, unit, state_class):
@@ -42,36 +124,249 @@ def create_sensor_schema(icon, accuracy_decimals, device_class, unit, state_clas
         state_class=state_class,
     )
 
+# When a reading is published, checked on the raw value before the sensor filters.
+# Set on the chip as defaults for all its sensors, or on a sensor.
+PUBLISH_DEFAULTS_SCHEMA = cv.Schema(
+    {
+        cv.Optional(CONF_DEADBAND_PERCENT): cv.percentage,
+        cv.Optional(CONF_MIN_PUBLISH_INTERVAL): cv.positive_time_period_milliseconds,
+        cv.Optional(CONF_MAX_PUBLISH_INTERVAL): cv.positive_time_period_milliseconds,
+    }
+)
+# An absolute deadband is in the sensor's unit, so only per sensor
+PUBLISH_POLICY_SCHEMA = PUBLISH_DEFAULTS_SCHEMA.extend(
+    {
+        cv.Optional(CONF_DEADBAND): cv.positive_float,
+    }
+)
+
+# A measurement sensor with its publish policy
+def create_gated_sensor_schema(icon, accuracy_decimals, device_class, unit, state_class):
+    return create_sensor_schema(icon, accuracy_decimals, device_class, unit, state_class).extend(PUBLISH_POLICY_SCHEMA)
+
+# Publish policy of a sensor, its own settings over the chip defaults. None if it publishes every reading.
+def publish_policy(config, sensor_config):
+    merged = {**config, **sensor_config}
+    deadband = merged.get(CONF_DEADBAND, 0.0)
+    deadband_ratio = merged.get(CONF_DEADBAND_PERCENT, 0.0)
+    min_interval = merged[CONF_MIN_PUBLISH_INTERVAL].total_milliseconds if CONF_MIN_PUBLISH_INTERVAL in merged else 0
+    max_interval = merged[CONF_MAX_PUBLISH_INTERVAL].total_milliseconds if CONF_MAX_PUBLISH_INTERVAL in merged else 0
+    if not (deadband or deadband_ratio or min_interval or max_interval):
+        return None
+    return cg.StructInitializer(
+        PublishPolicy,
+        ("deadband", deadband),
+        ("deadband_ratio", deadband_ratio),
+        ("min_interval_ms", min_interval),
+        ("max_interval_ms", max_interval),
+    )
+
+# Summaries of a channel's current and power over each statistics window, e.g. power_max
+STAT_KINDS = {
+    "min": StatKind.MIN,
+    "max": StatKind.MAX,
+    "mean": StatKind.MEAN,
+    "stddev": StatKind.STDDEV,
+    "rms": StatKind.RMS,
+}
+STAT_QUANTITIES = {
+    CONF_CURRENT: (ChannelSlot.CURRENT, create_sensor_schema(ICON_CURRENT_AC, 3, DEVICE_CLASS_CURRENT, UNIT_AMPERE, STATE_CLASS_MEASUREMENT)),
+    CONF_POWER: (ChannelSlot.POWER, create_sensor_schema(ICON_POWER, 3, DEVICE_CLASS_POWER, UNIT_WATT, STATE_CLASS_MEASUREMENT)),
+}
+
+# Overload limit of a channel, watched between sweeps. Trips above threshold, re-arms below threshold - hysteresis.
+OVERLOAD_LIMIT_SCHEMA = cv.Schema(
+    {
+        cv.Required(CONF_THRESHOLD): cv.positive_float,
+        cv.Optional(CONF_HYSTERESIS, default=0.0): cv.positive_float,
+    }
+)
+
+# Harmonic content in percent of the fundamental
+HARMONIC_SENSOR_SCHEMA = cv.maybe_simple_value(
+    sensor.sensor_schema(
+        icon=ICON_HARMONICS,
+        accuracy_decimals=2,
+        unit_of_measurement=UNIT_PERCENT,
+        state_class=STATE_CLASS_MEASUREMENT,
+    ),
+    key=CONF_NAME,
+)
+HARMONIC_ORDERS = range(2, 16)
+
+# Longest a segment may block loop(), samples x sample_interval
+MAX_SEGMENT_TIME_US = 100000
+
+def validate_waveform(config):
+    segment_us = config[CONF_SAMPLES] * config[CONF_SAMPLE_INTERVAL].total_microseconds
+    if segment_us > MAX_SEGMENT_TIME_US:
+        raise cv.Invalid(
+            f"{CONF_SAMPLES} x {CONF_SAMPLE_INTERVAL} is {segment_us / 1000:.0f} ms, a segment blocks loop() "
+            f"for that long; keep it at {MAX_SEGMENT_TIME_US // 1000} ms or less"
+        )
+    for order in HARMONIC_ORDERS:
+        if f"{CONF_HARMONIC}_{order}" in config and order > config[CONF_MAX_HARMONIC]:
+            raise cv.Invalid(f"{CONF_HARMONIC}_{order} is above {CONF_MAX_HARMONIC}")
+    return config
+
+# Waveform capture of a channel's current or the voltage, analysed for harmonics while the bus is idle
+WAVEFORM_SCHEMA = cv.All(
+    cv.Schema(
+        {
+            cv.Required(CONF_CHANNEL): cv.Any(cv.one_of(CONF_VOLTAGE, lower=True), cv.int_range(min=1, max=10)),
+            cv.Optional(CONF_CAPTURE_INTERVAL, default="60s"): cv.positive_time_period_milliseconds,
+            # Samples per segment, each segment is read in one blocking burst (SPI only)
+            cv.Optional(CONF_SAMPLES, default=256): cv.int_range(min=16, max=2048),
+            # Time between samples, 0 reads them as fast as the bus allows
+            cv.Optional(CONF_SAMPLE_INTERVAL, default="0us"): cv.positive_time_period_microseconds,
+            # Segments averaged per capture
+            cv.Optional(CONF_SEGMENTS, default=4): cv.int_range(min=1, max=64),
+            cv.Optional(CONF_MAX_HARMONIC, default=15): cv.int_range(min=2, max=15),
+            cv.Optional(CONF_THD): HARMONIC_SENSOR_SCHEMA,
+            **{cv.Optional(f"{CONF_HARMONIC}_{order}"): HARMONIC_SENSOR_SCHEMA for order in HARMONIC_ORDERS},
+        }
+    ),
+    validate_waveform,
+)
+
+# Bus health of a chip: counters since boot, and loop() blocking times over each interval
+def diagnostic_sensor_schema(icon, accuracy_decimals, state_class, **kwargs):
+    return cv.maybe_simple_value(
+        sensor.sensor_schema(
+            icon=icon,
+            accuracy_decimals=accuracy_decimals,
+            state_class=state_class,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+            **kwargs,
+        ),
+        key=CONF_NAME,
+    )
+
+DIAGNOSTIC_COUNTER_SCHEMA = diagnostic_sensor_schema(ICON_COUNTER, 0, STATE_CLASS_TOTAL_INCREASING)
+DIAGNOSTIC_ERROR_SCHEMA = diagnostic_sensor_schema(ICON_BUS_ERROR, 0, STATE_CLASS_TOTAL_INCREASING)
+DIAGNOSTIC_TIME_SCHEMA = diagnostic_sensor_schema(ICON_TIMER, 3, STATE_CLASS_MEASUREMENT, unit_of_measurement=UNIT_MILLISECOND)
+DIAGNOSTIC_SENSORS = {
+    "frames_sent": (DiagnosticSlot.FRAMES, DIAGNOSTIC_COUNTER_SCHEMA),
+    "bytes_on_wire": (DiagnosticSlot.BYTES, DIAGNOSTIC_COUNTER_SCHEMA),
+    "checksum_errors": (DiagnosticSlot.CHECKSUM_ERRORS, DIAGNOSTIC_ERROR_SCHEMA),
+    "timeouts": (DiagnosticSlot.TIMEOUTS, DIAGNOSTIC_ERROR_SCHEMA),
+    "retries": (DiagnosticSlot.RETRIES, DIAGNOSTIC_ERROR_SCHEMA),
+    "discarded_reads": (DiagnosticSlot.DISCARDED_READS, DIAGNOSTIC_ERROR_SCHEMA),
+    "loop_time_p50": (DiagnosticSlot.LOOP_TIME_P50, DIAGNOSTIC_TIME_SCHEMA),
+    "loop_time_p99": (DiagnosticSlot.LOOP_TIME_P99, DIAGNOSTIC_TIME_SCHEMA),
+    "loop_time_max": (DiagnosticSlot.LOOP_TIME_MAX, DIAGNOSTIC_TIME_SCHEMA),
+    CONF_SWEEP_DURATION: (DiagnosticSlot.SWEEP_DURATION, DIAGNOSTIC_TIME_SCHEMA),
+    CONF_DATA_RATE: (DiagnosticSlot.DATA_RATE, diagnostic_sensor_schema(ICON_DATA_RATE, 0, STATE_CLASS_MEASUREMENT, unit_of_measurement="kHz")),
+}
+DIAGNOSTICS_SCHEMA = cv.Schema(
+    {
+        # Sensors publish once per interval, loop() percentiles cover the interval
+        cv.Optional(CONF_INTERVAL, default="60s"): cv.positive_time_period_milliseconds,
+        **{cv.Optional(key): schema for key, (_, schema) in DIAGNOSTIC_SENSORS.items()},
+    }
+)
+
 # Base configuration schema without communication specific options
 BASE_CONFIG_SCHEMA = cv.Schema(
     {
-        cv.Optional(CONF_FREQUENCY): create_sensor_schema(ICON_FREQUENCY, 2, DEVICE_CLASS_FREQUENCY, UNIT_HERTZ, STATE_CLASS_MEASUREMENT),
-        cv.Optional(CONF_TEMPERATURE): create_sensor_schema(ICON_THERMOMETER, 2, DEVICE_CLASS_TEMPERATURE, UNIT_CELSIUS, STATE_CLASS_MEASUREMENT),
-        cv.Optional(CONF_VOLTAGE): create_sensor_schema(ICON_VOLTAGE, 1, DEVICE_CLASS_VOLTAGE, UNIT_VOLT, STATE_CLASS_MEASUREMENT),
-        cv.Optional(CONF_TOTAL_POWER): create_sensor_schema(ICON_POWER, 3, DEVICE_CLASS_POWER, UNIT_WATT, STATE_CLASS_MEASUREMENT),
-        cv.Optional(CONF_TOTAL_ENERGY): create_sensor_schema(ICON_ENERGY, 3, DEVICE_CLASS_ENERGY, UNIT_KILOWATT_HOURS, STATE_CLASS_TOTAL_INCREASING),
+        cv.Optional(CONF_FREQUENCY): create_gated_sensor_schema(ICON_FREQUENCY, 2, DEVICE_CLASS_FREQUENCY, UNIT_HERTZ, STATE_CLASS_MEASUREMENT),
+        cv.Optional(CONF_TEMPERATURE): create_gated_sensor_schema(ICON_THERMOMETER, 2, DEVICE_CLASS_TEMPERATURE, UNIT_CELSIUS, STATE_CLASS_MEASUREMENT),
+        cv.Optional(CONF_VOLTAGE): create_gated_sensor_schema(ICON_VOLTAGE, 1, DEVICE_CLASS_VOLTAGE, UNIT_VOLT, STATE_CLASS_MEASUREMENT),
+        cv.Optional(CONF_TOTAL_POWER): create_gated_sensor_schema(ICON_POWER, 3, DEVICE_CLASS_POWER, UNIT_WATT, STATE_CLASS_MEASUREMENT),
+        cv.Optional(CONF_TOTAL_ENERGY): create_gated_sensor_schema(ICON_ENERGY, 3, DEVICE_CLASS_ENERGY, UNIT_KILOWATT_HOURS, STATE_CLASS_TOTAL_INCREASING),
+        # Time one loop() call may spend sending and collecting reads
+        cv.Optional(CONF_LOOP_BUDGET, default="1ms"): cv.positive_time_period_microseconds,
+        # UART read commands sent ahead of their replies, 1 for strict request/response
+        cv.Optional(CONF_PIPELINE_DEPTH, default=4): cv.int_range(min=1, max=8),
+        # Failed reads sent again per update at most, 0 to never retry
+        cv.Optional(CONF_RETRY_BUDGET, default=4): cv.int_range(min=0, max=255),
+        # Read voltage with each channel's current and power for power factor/apparent power
+        cv.Optional(CONF_SNAPSHOT_SAMPLING, default=False): cv.boolean,
+        # Below this apparent power power factor is published as unknown
+        cv.Optional(CONF_MIN_APPARENT_POWER, default=1.0): cv.positive_float,
+        # Keep accumulated energy across reboots; saved once energy_save_threshold Wh are unsaved
+        # or energy_save_interval has passed, whichever comes first. Off by default, as it writes
+        # to flash.
+        cv.Optional(CONF_RESTORE_ENERGY, default=False): cv.boolean,
+        cv.Optional(CONF_ENERGY_SAVE_THRESHOLD, default=10.0): cv.positive_float,
+        cv.Optional(CONF_ENERGY_SAVE_INTERVAL, default="10min"): cv.positive_time_period_milliseconds,
+        # Channel statistics sensors publish once per window
+        cv.Optional(CONF_STATISTICS_WINDOW, default="60s"): cv.positive_time_period_milliseconds,
+        # Channels with an overload limit have their current/power read this often between register groups
+        cv.Optional(CONF_WATCH_INTERVAL, default="100ms"): cv.positive_time_period_microseconds,
+        cv.Optional(CONF_ON_OVERCURRENT): automation.validate_automation(
+            {
+                cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(OvercurrentTrigger),
+            }
+        ),
+        cv.Optional(CONF_ON_OVERPOWER): automation.validate_automation(
+            {
+                cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(OverpowerTrigger),
+            }
+        ),
+        cv.Optional(CONF_WAVEFORM): WAVEFORM_SCHEMA,
+        cv.Optional(CONF_DIAGNOSTICS): DIAGNOSTICS_SCHEMA,
+        # Record the latest frames exchanged with the chip, logged by bl0910.dump_trace
+        cv.Optional(CONF_TRACE): cv.Schema(
+            {
+                cv.Optional(CONF_CAPACITY, default=256): cv.int_range(min=1, max=4096),
+            }
+        ),
+        # Each sweep's readings as one binary frame, see telemetry.h for the format
+        cv.Optional(CONF_TELEMETRY): cv.Schema(
+            {
+                cv.Optional(CONF_CHIP, default=0): cv.uint8_t,
+                cv.Required(CONF_ON_FRAME): automation.validate_automation(
+                    {
+                        cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(TelemetryTrigger),
+                    }
+                ),
+            }
+        ),
+        # One calibrated register is read back this often to catch a chip reset, 0s = never
+        cv.Optional(CONF_VERIFY_INTERVAL, default="60s"): cv.positive_time_period_milliseconds,
+        # Poll changing channels every update_interval and steady ones down to once per max_staleness
+        cv.Optional(CONF_ADAPTIVE_POLLING): cv.Schema(
+            {
+                cv.Optional(CONF_MAX_STALENESS, default="30s"): cv.positive_time_period_milliseconds,
+                cv.Optional(CONF_CHANGE_THRESHOLD, default="5%"): cv.percentage,
+                # Bus budget per update, 0 for no limit
+                cv.Optional(CONF_MAX_READS_PER_UPDATE, default=0): cv.int_range(min=0, max=255),
+            }
+        ),
     }
-).extend(
+).extend(PUBLISH_DEFAULTS_SCHEMA).extend(
     cv.Schema(
         {
             cv.Optional(f"{CONF_CHANNEL}_{i + 1}"): cv.Schema(
                 {
                     cv.Optional(CONF_CURRENT): cv.maybe_simple_value(
-                        create_sensor_schema(ICON_CURRENT_AC, 3, DEVICE_CLASS_CURRENT, UNIT_AMPERE, STATE_CLASS_MEASUREMENT),
+                        create_gated_sensor_schema(ICON_CURRENT_AC, 3, DEVICE_CLASS_CURRENT, UNIT_AMPERE, STATE_CLASS_MEASUREMENT),
                         key=CONF_NAME,
                     ),
                     cv.Optional(CONF_POWER): cv.maybe_simple_value(
-                        create_sensor_schema(ICON_POWER, 3, DEVICE_CLASS_POWER, UNIT_WATT, STATE_CLASS_MEASUREMENT),
+                        create_gated_sensor_schema(ICON_POWER, 3, DEVICE_CLASS_POWER, UNIT_WATT, STATE_CLASS_MEASUREMENT),
                         key=CONF_NAME,
                     ),
                     cv.Optional(CONF_ENERGY): cv.maybe_simple_value(
-                        create_sensor_schema(ICON_ENERGY, 3, DEVICE_CLASS_ENERGY, UNIT_KILOWATT_HOURS, STATE_CLASS_TOTAL_INCREASING),
+                        create_gated_sensor_schema(ICON_ENERGY, 3, DEVICE_CLASS_ENERGY, UNIT_KILOWATT_HOURS, STATE_CLASS_TOTAL_INCREASING),
                         key=CONF_NAME,
                     ),
                     cv.Optional(CONF_POWER_FACTOR): cv.maybe_simple_value(
-                        create_sensor_schema(ICON_POWER_FACTOR, 3, DEVICE_CLASS_POWER_FACTOR, "", STATE_CLASS_MEASUREMENT),
+                        create_gated_sensor_schema(ICON_POWER_FACTOR, 3, DEVICE_CLASS_POWER_FACTOR, "", STATE_CLASS_MEASUREMENT),
+                        key=CONF_NAME,
+                    ),
+                    cv.Optional(CONF_APPARENT_POWER): cv.maybe_simple_value(
+                        create_gated_sensor_schema(ICON_POWER, 3, DEVICE_CLASS_APPARENT_POWER, UNIT_VOLT_AMPS, STATE_CLASS_MEASUREMENT),
                         key=CONF_NAME,
                     ),
+                    cv.Optional(CONF_OVERCURRENT): OVERLOAD_LIMIT_SCHEMA,
+                    cv.Optional(CONF_OVERPOWER): OVERLOAD_LIMIT_SCHEMA,
+                    **{
+                        cv.Optional(f"{quantity}_{kind}"): cv.maybe_simple_value(schema, key=CONF_NAME)
+                        for quantity, (_, schema) in STAT_QUANTITIES.items()
+                        for kind in STAT_KINDS
+                    },
                 }
             )
             for i in range(10) # Create 10 channel configurations
@@ -86,25 +381,114 @@ COMM_MODE_SCHEMA = cv.Schema(
     }
 )
 
+# A waveform segment is read in one blocking burst. Over UART 256 samples block loop() for about
+# 0.8 s at 19200 baud, and the sample rate resolves the 2nd harmonic at best, so it needs SPI.
+def validate_waveform_interface(config):
+    if CONF_WAVEFORM in config:
+        raise cv.Invalid(f"{CONF_WAVEFORM} requires SPI", [CONF_WAVEFORM])
+    return config
+
 # UART mode configuration
 UART_CONFIG_SCHEMA = BASE_CONFIG_SCHEMA.extend(uart.UART_DEVICE_SCHEMA).extend(
     {
         cv.GenerateID(): cv.declare_id(BL0910UART),
     }
+).add_extra(validate_waveform_interface)
+
+# Options for a chip swept by a hub
+HUB_CHIP_SCHEMA = cv.Schema(
+    {
+        cv.Optional(CONF_HUB_ID): cv.use_id(BL0910Hub),
+        # Chips on the same phase can share one voltage/frequency reading, 0 = not shared
+        cv.Optional(CONF_PHASE, default=0): cv.int_range(min=0, max=3),
+    }
+)
+
+def validate_data_rate_tuning(config):
+    if config[CONF_MIN_DATA_RATE] > config[CONF_MAX_DATA_RATE]:
+        raise cv.Invalid(f"{CONF_MIN_DATA_RATE} is above {CONF_MAX_DATA_RATE}")
+    return config
+
+# Step the SPI clock up while checksum errors stay within max_error_rate of the frames, down as soon as they do not
+DATA_RATE_TUNING_SCHEMA = cv.All(
+    cv.Schema(
+        {
+            cv.Optional(CONF_MIN_DATA_RATE, default="200kHz"): cv.frequency,
+            cv.Optional(CONF_MAX_DATA_RATE, default="8MHz"): cv.frequency,
+            cv.Optional(CONF_MAX_ERROR_RATE, default="0.1%"): cv.All(cv.percentage, cv.Range(min=0.0001)),
+        }
+    ),
+    validate_data_rate_tuning,
 )
 
 # SPI mode configuration
-SPI_CONFIG_SCHEMA = BASE_CONFIG_SCHEMA.extend(spi.spi_device_schema()).extend(
+SPI_CONFIG_SCHEMA = BASE_CONFIG_SCHEMA.extend(spi.spi_device_schema(cs_pin_required=True, default_data_rate="1MHz")).extend(HUB_CHIP_SCHEMA).extend(
     {
         cv.GenerateID(): cv.declare_id(BL0910SPI),
+        # Read a whole channel block in one chip select assertion
+        cv.Optional(CONF_SPI_BURST, default=False): cv.boolean,
+        cv.Optional(CONF_DATA_RATE_TUNING): DATA_RATE_TUNING_SCHEMA,
     }
 )
 
+# Hub mode configuration: sweeps several SPI chips on one bus in turn
+HUB_CONFIG_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(): cv.declare_id(BL0910Hub),
+        cv.Optional(CONF_SHARE_LINE_READINGS, default=False): cv.boolean,
+        cv.Optional(CONF_LOOP_BUDGET, default="1ms"): cv.positive_time_period_microseconds,
+        cv.Optional(CONF_SWEEP_DURATION): sensor.sensor_schema(
+            icon=ICON_TIMER,
+            accuracy_decimals=2,
+            unit_of_measurement=UNIT_MILLISECOND,
+            state_class=STATE_CLASS_MEASUREMENT,
+            entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+        ),
+    }
+).extend(cv.polling_component_schema("10s"))
+
+# The emulated interface picks the framing the chip class is compiled for
+def validate_emulator(config):
+    # A hub drives its chips with SPI frames
+    if CONF_HUB_ID in config and config[CONF_EMULATED_INTERFACE] != CONF_MODE_SPI:
+        raise cv.Invalid(f"{CONF_HUB_ID} requires {CONF_EMULATED_INTERFACE}: {CONF_MODE_SPI}")
+    if CONF_DATA_RATE_TUNING in config and config[CONF_EMULATED_INTERFACE] != CONF_MODE_SPI:
+        raise cv.Invalid(f"{CONF_DATA_RATE_TUNING} requires {CONF_EMULATED_INTERFACE}: {CONF_MODE_SPI}")
+    if CONF_WAVEFORM in config and config[CONF_EMULATED_INTERFACE] != CONF_MODE_SPI:
+        raise cv.Invalid(f"{CONF_WAVEFORM} requires {CONF_EMULATED_INTERFACE}: {CONF_MODE_SPI}")
+    if config[CONF_EMULATED_INTERFACE] == CONF_MODE_SPI:
+        config[CONF_ID].type = BL0910EmulatedSPI
+    return config
+
+# Emulator mode configuration: a software chip, no bus required (e.g. for the host platform)
+EMULATOR_CONFIG_SCHEMA = BASE_CONFIG_SCHEMA.extend(HUB_CHIP_SCHEMA).extend(
+    {
+        cv.GenerateID(): cv.declare_id(BL0910EmulatedUART),
+        cv.Optional(CONF_EMULATED_INTERFACE, default=CONF_MODE_UART): cv.one_of(CONF_MODE_UART, CONF_MODE_SPI, lower=True),
+        # Wire speed of the emulated UART, 0 for an instantaneous bus
+        cv.Optional(CONF_BAUD_RATE, default=19200): cv.int_range(min=0),
+        cv.Optional(CONF_REPLY_LATENCY, default="0us"): cv.positive_time_period_microseconds,
+        cv.Optional(CONF_NOISE, default=0): cv.int_range(min=0, max=0x7FFFFF),
+        # Probability of a corrupted reply byte
+        cv.Optional(CONF_CORRUPTION_RATE, default=0.0): cv.percentage,
+        cv.Optional(CONF_SEED, default=1): cv.int_range(min=1, max=0xFFFFFFFF),
+        cv.Optional(CONF_SPI_BURST, default=False): cv.boolean,
+        # Clock of the emulated SPI bus, and the clock above which replies corrupt more the faster it runs
+        cv.Optional(CONF_DATA_RATE, default="1MHz"): cv.frequency,
+        cv.Optional(CONF_CLEAN_DATA_RATE): cv.frequency,
+        cv.Optional(CONF_DATA_RATE_TUNING): DATA_RATE_TUNING_SCHEMA,
+        # Log holding a bl0910.dump_trace output: reads are answered from it instead of the model
+        cv.Optional(CONF_REPLAY): cv.file_,
+    }
+).add_extra(validate_emulator)
+
 # Combined configuration schema
 CONFIG_SCHEMA = cv.typed_schema(
     {
         CONF_MODE_UART: UART_CONFIG_SCHEMA,
         CONF_MODE_SPI: SPI_CONFIG_SCHEMA,
+        CONF_MODE_EMULATOR: EMULATOR_CONFIG_SCHEMA,
+        CONF_MODE_HUB: HUB_CONFIG_SCHEMA,
     },
     key=CONF_MODE,
     default_type=CONF_MODE_UART,
@@ -135,6 +519,107 @@ async def reset_energy_to_code(config, action_id, template_arg, args):
     await cg.register_parented(var, config[CONF_ID])
     return var
 
+# Calibration actions: correct a channel so that its latest reading becomes the reference. All
+# calibrations of a chip until its next register group are written, verified and saved as one batch.
+CALIBRATE_OFFSET_SCHEMA = cv.Schema(
+    {
+        cv.Required(CONF_ID): cv.use_id(BL0910),
+        cv.Required(CONF_CHANNEL): cv.templatable(cv.int_range(min=1, max=10)),
+        # Current the channel should read, normally 0 with no load
+        cv.Optional(CONF_REFERENCE, default=0.0): cv.templatable(cv.positive_float),
+    }
+)
+CALIBRATE_GAIN_SCHEMA = cv.Schema(
+    {
+        cv.Required(CONF_ID): cv.use_id(BL0910),
+        cv.Required(CONF_CHANNEL): cv.templatable(cv.int_range(min=1, max=10)),
+        # Current (A) or power (W) measured by a reference meter
+        cv.Required(CONF_REFERENCE): cv.templatable(cv.positive_float),
+        cv.Optional(CONF_QUANTITY, default=CONF_CURRENT): cv.enum(
+            {CONF_CURRENT: CalibrationKind.CURRENT_GAIN, CONF_POWER: CalibrationKind.POWER_GAIN}, lower=True
+        ),
+    }
+)
+
+async def calibrate_to_code(config, action_id, template_arg, args, kind):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    cg.add(var.set_kind(kind))
+    channel = await cg.templatable(config[CONF_CHANNEL], args, cg.uint8)
+    cg.add(var.set_channel(channel))
+    reference = await cg.templatable(config[CONF_REFERENCE], args, cg.float_)
+    cg.add(var.set_reference(reference))
+    return var
+
+@automation.register_action("bl0910.calibrate_offset", CalibrateAction, CALIBRATE_OFFSET_SCHEMA)
+async def calibrate_offset_to_code(config, action_id, template_arg, args):
+    return await calibrate_to_code(config, action_id, template_arg, args, CalibrationKind.CURRENT_OFFSET)
+
+@automation.register_action("bl0910.calibrate_gain", CalibrateAction, CALIBRATE_GAIN_SCHEMA)
+async def calibrate_gain_to_code(config, action_id, template_arg, args):
+    return await calibrate_to_code(config, action_id, template_arg, args, config[CONF_QUANTITY])
+
+# Register "write register" action: a raw write, calibration registers go through the shadow
+@automation.register_action(
+    "bl0910.write_register",
+    WriteRegisterAction,
+    cv.Schema(
+        {
+            cv.Required(CONF_ID): cv.use_id(BL0910),
+            cv.Required(CONF_ADDRESS): cv.templatable(cv.hex_int_range(min=0, max=0xFF)),
+            cv.Required(CONF_VALUE): cv.templatable(cv.int_range(min=-(1 << 23), max=(1 << 24) - 1)),
+        }
+    ),
+)
+async def write_register_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    address = await cg.templatable(config[CONF_ADDRESS], args, cg.uint8)
+    cg.add(var.set_address(address))
+    value = await cg.templatable(config[CONF_VALUE], args, cg.int32)
+    cg.add(var.set_value(value))
+    return var
+
+# Register "capture waveform" action: start a capture now rather than at the next interval
+@automation.register_action(
+    "bl0910.capture_waveform",
+    CaptureWaveformAction,
+    maybe_simple_id(
+        {
+            cv.Required(CONF_ID): cv.use_id(BL0910),
+        }
+    ),
+)
+async def capture_waveform_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    return var
+
+# Register "dump trace" action: log the recorded frames for replay on the host
+@automation.register_action(
+    "bl0910.dump_trace",
+    DumpTraceAction,
+    maybe_simple_id(
+        {
+            cv.Required(CONF_ID): cv.use_id(BL0910),
+        }
+    ),
+)
+async def dump_trace_to_code(config, action_id, template_arg, args):
+    var = cg.new_Pvariable(action_id, template_arg)
+    await cg.register_parented(var, config[CONF_ID])
+    return var
+
+# Records of every "TRACE" line in a log, in order, as one string for the emulator
+TRACE_LINE = re.compile(r"TRACE((?:\s+[0-9A-Fa-f]{20}(?![0-9A-Fa-f]))+)")
+
+def load_trace(path):
+    with open(CORE.relative_config_path(path), encoding="utf-8", errors="replace") as log:
+        records = [record for match in TRACE_LINE.finditer(log.read()) for record in match.group(1).split()]
+    if not records:
+        raise cv.Invalid(f"No trace records in {path}")
+    return " ".join(records)
+
 # Helper function to create and register sensors
 async def register_sensor(var, config, sensor_name, sensor_fn):
     if sensor_config := config.get(sensor_name):
@@ -144,20 +629,133 @@ async def register_sensor(var, config, sensor_name, sensor_fn):
 # Main function: generate code based on configuration
 async def to_code(config):
     mode = config[CONF_MODE]
-    
+
+    if mode == CONF_MODE_HUB:
+        var = cg.new_Pvariable(config[CONF_ID])
+        await cg.register_component(var, config)
+        cg.add(var.set_share_line_readings(config[CONF_SHARE_LINE_READINGS]))
+        cg.add(var.set_loop_budget(config[CONF_LOOP_BUDGET].total_microseconds))
+        await register_sensor(var, config, CONF_SWEEP_DURATION, var.set_sweep_duration_sensor)
+        return
+
     if mode == CONF_MODE_UART:
         var = cg.new_Pvariable(config[CONF_ID])
         await cg.register_component(var, config)
         await uart.register_uart_device(var, config)
-        # Set UART communication mode
-        cg.add(var.set_comm_mode(cg.RawExpression("esphome::bl0910::CommunicationMode::UART")))
-    
+
     elif mode == CONF_MODE_SPI:
         var = cg.new_Pvariable(config[CONF_ID])
         await cg.register_component(var, config)
         await spi.register_spi_device(var, config)
-        # Set SPI communication mode
-        cg.add(var.set_comm_mode(cg.RawExpression("esphome::bl0910::CommunicationMode::SPI")))
+        cg.add(var.set_spi_burst(config[CONF_SPI_BURST]))
+
+    elif mode == CONF_MODE_EMULATOR:
+        var = cg.new_Pvariable(config[CONF_ID])
+        await cg.register_component(var, config)
+        if config[CONF_EMULATED_INTERFACE] == CONF_MODE_SPI:
+            cg.add(var.set_spi_burst(config[CONF_SPI_BURST]))
+            byte_time = 0
+        else:
+            # 8N1: ten bit times per byte
+            baud_rate = config[CONF_BAUD_RATE]
+            byte_time = 10 * 1000000 // baud_rate if baud_rate else 0
+        emulator_config = cg.StructInitializer(
+            EmulatorConfig,
+            ("seed", config[CONF_SEED]),
+            ("noise_lsb", config[CONF_NOISE]),
+            ("reply_latency_us", config[CONF_REPLY_LATENCY].total_microseconds),
+            ("byte_time_us", byte_time),
+            ("corruption_ppm", int(config[CONF_CORRUPTION_RATE] * 1000000)),
+            ("spi_clock_hz", int(config[CONF_DATA_RATE])),
+            ("clean_clock_hz", int(config.get(CONF_CLEAN_DATA_RATE, 0))),
+        )
+        cg.add(var.set_emulator_config(emulator_config))
+        if replay := config.get(CONF_REPLAY):
+            cg.add(var.set_emulator_replay(load_trace(replay)))
+
+    if tuning_config := config.get(CONF_DATA_RATE_TUNING):
+        cg.add(
+            var.set_data_rate_tuning(
+                int(tuning_config[CONF_MIN_DATA_RATE]),
+                int(tuning_config[CONF_MAX_DATA_RATE]),
+                tuning_config[CONF_MAX_ERROR_RATE],
+            )
+        )
+    cg.add(var.set_loop_budget(config[CONF_LOOP_BUDGET].total_microseconds))
+    cg.add(var.set_pipeline_depth(config[CONF_PIPELINE_DEPTH]))
+    cg.add(var.set_retry_budget(config[CONF_RETRY_BUDGET]))
+    cg.add(var.set_snapshot_sampling(config[CONF_SNAPSHOT_SAMPLING]))
+    cg.add(var.set_min_apparent_power(config[CONF_MIN_APPARENT_POWER]))
+    cg.add(var.set_restore_energy(config[CONF_RESTORE_ENERGY]))
+    cg.add(var.set_energy_preference_key(str(config[CONF_ID].id)))
+    cg.add(var.set_calibration_preference_key(str(config[CONF_ID].id)))
+    cg.add(var.set_verify_interval(config[CONF_VERIFY_INTERVAL].total_milliseconds))
+    cg.add(var.set_energy_save_threshold(config[CONF_ENERGY_SAVE_THRESHOLD]))
+    cg.add(var.set_energy_save_interval(config[CONF_ENERGY_SAVE_INTERVAL].total_milliseconds))
+    cg.add(var.set_statistics_window(config[CONF_STATISTICS_WINDOW].total_milliseconds))
+    cg.add(var.set_watch_interval(config[CONF_WATCH_INTERVAL].total_microseconds))
+    for conf in config.get(CONF_ON_OVERCURRENT, []):
+        trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var)
+        await automation.build_automation(trigger, [(cg.uint8, "channel"), (cg.float_, "current")], conf)
+    for conf in config.get(CONF_ON_OVERPOWER, []):
+        trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var)
+        await automation.build_automation(trigger, [(cg.uint8, "channel"), (cg.float_, "power")], conf)
+    if trace_config := config.get(CONF_TRACE):
+        cg.add(var.set_trace_capacity(trace_config[CONF_CAPACITY]))
+    if telemetry_config := config.get(CONF_TELEMETRY):
+        cg.add(var.set_telemetry_chip(telemetry_config[CONF_CHIP]))
+        for conf in telemetry_config[CONF_ON_FRAME]:
+            trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var)
+            await automation.build_automation(
+                trigger, [(cg.uint8.operator("const").operator("ptr"), "data"), (cg.size_t, "size")], conf
+            )
+    if adaptive_config := config.get(CONF_ADAPTIVE_POLLING):
+        cg.add(
+            var.set_adaptive_polling(
+                adaptive_config[CONF_MAX_STALENESS].total_milliseconds,
+                adaptive_config[CONF_CHANGE_THRESHOLD],
+                adaptive_config[CONF_MAX_READS_PER_UPDATE],
+            )
+        )
+    if waveform_config := config.get(CONF_WAVEFORM):
+        channel = waveform_config[CONF_CHANNEL]
+        cg.add(
+            var.set_waveform_capture(
+                bl0910_ns.WAVEFORM_VOLTAGE if channel == CONF_VOLTAGE else channel,
+                waveform_config[CONF_SAMPLES],
+                waveform_config[CONF_SAMPLE_INTERVAL].total_microseconds,
+                waveform_config[CONF_SEGMENTS],
+                waveform_config[CONF_CAPTURE_INTERVAL].total_milliseconds,
+                waveform_config[CONF_MAX_HARMONIC],
+            )
+        )
+        await register_sensor(var, waveform_config, CONF_THD, var.set_thd_sensor)
+        for order in HARMONIC_ORDERS:
+            if sensor_config := waveform_config.get(f"{CONF_HARMONIC}_{order}"):
+                sens = await sensor.new_sensor(sensor_config)
+                cg.add(var.set_harmonic_sensor(order, sens))
+    if diagnostics_config := config.get(CONF_DIAGNOSTICS):
+        cg.add(var.set_diagnostics_interval(diagnostics_config[CONF_INTERVAL].total_milliseconds))
+        for key, (slot, _) in DIAGNOSTIC_SENSORS.items():
+            if sensor_config := diagnostics_config.get(key):
+                sens = await sensor.new_sensor(sensor_config)
+                cg.add(var.set_diagnostic_sensor(slot, sens))
+    if hub_id := config.get(CONF_HUB_ID):
+        hub = await cg.get_variable(hub_id)
+        cg.add(hub.register_chip(var, config[CONF_PHASE]))
+
+    # Only channels with a sensor are ever polled: bit 0 for the chip-wide registers, bit n for channel n
+    channel_mask = 0
+    if any(key in config for key in (CONF_FREQUENCY, CONF_TEMPERATURE, CONF_VOLTAGE, CONF_TOTAL_POWER, CONF_TOTAL_ENERGY)):
+        channel_mask |= 1
+    for i in range(10):
+        if channel_config := config.get(f"{CONF_CHANNEL}_{i + 1}"):
+            channel_mask |= 1 << (i + 1)
+            # Derived values need the chip-wide voltage read unless each channel reads its own
+            derived = CONF_POWER_FACTOR in channel_config or CONF_APPARENT_POWER in channel_config
+            if derived and not config[CONF_SNAPSHOT_SAMPLING]:
+                channel_mask |= 1
+    cg.add(var.set_channel_mask(channel_mask))
 
     # Register sensors: frequency, temperature, voltage, total power, total energy
     await register_sensor(var, config, CONF_FREQUENCY, var.set_frequency_sensor)
@@ -165,11 +763,38 @@ async def to_code(config):
     await register_sensor(var, config, CONF_VOLTAGE, var.set_voltage_sensor)
     await register_sensor(var, config, CONF_TOTAL_POWER, var.set_total_power_sensor)
     await register_sensor(var, config, CONF_TOTAL_ENERGY, var.set_total_energy_sensor)
+    chip_slots = {
+        CONF_FREQUENCY: SensorSlot.FREQUENCY,
+        CONF_TEMPERATURE: SensorSlot.TEMPERATURE,
+        CONF_VOLTAGE: SensorSlot.VOLTAGE,
+        CONF_TOTAL_POWER: SensorSlot.TOTAL_POWER,
+        CONF_TOTAL_ENERGY: SensorSlot.TOTAL_ENERGY,
+    }
+    for key, slot in chip_slots.items():
+        if (sensor_config := config.get(key)) and (policy := publish_policy(config, sensor_config)):
+            cg.add(var.set_publish_policy(slot, policy))
 
-    # Loop through 10 channels, register current, power, energy and power factor sensors for each
+    # Loop through 10 channels, register current, power, energy, power factor, apparent power and statistics sensors for each
+    channel_slots = {
+        CONF_CURRENT: ChannelSlot.CURRENT,
+        CONF_POWER: ChannelSlot.POWER,
+        CONF_ENERGY: ChannelSlot.ENERGY,
+        CONF_POWER_FACTOR: ChannelSlot.POWER_FACTOR,
+        CONF_APPARENT_POWER: ChannelSlot.APPARENT_POWER,
+    }
     for i in range(10):
         if channel_config := config.get(f"{CONF_CHANNEL}_{i + 1}"):
-            await register_sensor(var, channel_config, CONF_CURRENT, getattr(var, f"set_current_{i + 1}_sensor"))
-            await register_sensor(var, channel_config, CONF_POWER, getattr(var, f"set_power_{i + 1}_sensor"))
-            await register_sensor(var, channel_config, CONF_ENERGY, getattr(var, f"set_energy_{i + 1}_sensor"))
-            await register_sensor(var, channel_config, CONF_POWER_FACTOR, getattr(var, f"set_power_factor_{i + 1}_sensor")) 
\ No newline at end of file
+            for key, slot in channel_slots.items():
+                if sensor_config := channel_config.get(key):
+                    sens = await sensor.new_sensor(sensor_config)
+                    cg.add(var.set_channel_sensor(i + 1, slot, sens))
+                    if policy := publish_policy(config, sensor_config):
+                        cg.add(var.set_channel_publish_policy(i + 1, slot, policy))
+            for key, slot in ((CONF_OVERCURRENT, ChannelSlot.CURRENT), (CONF_OVERPOWER, ChannelSlot.POWER)):
+                if limit_config := channel_config.get(key):
+                    cg.add(var.set_overload_limit(i + 1, slot, limit_config[CONF_THRESHOLD], limit_config[CONF_HYSTERESIS]))
+            for quantity, (slot, _) in STAT_QUANTITIES.items():
+                for kind, stat_kind in STAT_KINDS.items():
+                    if sensor_config := channel_config.get(f"{quantity}_{kind}"):
+                        sens = await sensor.new_sensor(sensor_config)
+                        cg.add(var.set_channel_statistics_sensor(i + 1, slot, stat_kind, sens)) 
\ No newline at end of file
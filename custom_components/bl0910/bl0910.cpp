@@ -1,7 +1,9 @@
 #include "bl0910.h"
 #include "constants.h"
-#include <queue>
+#include <algorithm>
+#include <cmath>
 #include "esphome/core/log.h"
+#include "esphome/core/hal.h"
 
 namespace esphome
 {
@@ -9,456 +11,2176 @@ namespace esphome
   {
     // Define log tag as "bl0910"
     static const char *const TAG = "bl0910";
-    // Convert ube24_t type data to uint32_t type
-    constexpr uint32_t to_uint32_t(ube24_t input) { return input.h << 16 | input.m << 8 | input.l; }
-    // Convert sbe24_t type data to int32_t type
-    constexpr int32_t to_int32_t(sbe24_t input) { return input.h << 16 | input.m << 8 | input.l; }
+    // Raw 24-bit register value of a reply
+    constexpr uint32_t to_uint32_t(const DataPacket &input) { return (uint32_t) input.h << 16 | (uint32_t) input.m << 8 | input.l; }
     // Checksum calculation function, calculate the checksum of address and data bytes
     constexpr uint8_t bl0910_checksum(const uint8_t address, const DataPacket *data)
     {
-      return (address + data->l + data->m + data->h) ^ 0xFF;
+      return bl0910_frame_checksum(address, data->l, data->m, data->h);
     }
 
-    // Main loop to read and process data from different channels
-    void BL0910::loop()
+    // Convert a raw register value as its descriptor says
+    static float convert_(const RegisterDescriptor &reg, uint32_t raw)
     {
-      // If current_channel_ is UINT8_MAX, return directly
-      if (this->current_channel_ == UINT8_MAX)
+      if (reg.conversion == Conversion::RECIPROCAL)
       {
+        return raw == 0 ? NAN : reg.scale / (float) raw;
+      }
+      if (reg.is_signed)
+      {
+        // Sign-extend from the register width
+        int32_t value = (int32_t) (raw << (32 - reg.width)) >> (32 - reg.width);
+        return (float) value * reg.scale + reg.offset;
+      }
+      return (float) raw * reg.scale + reg.offset;
+    }
+
+    // Longest wait for a reply before the read is abandoned
+    static const uint32_t READ_TIMEOUT_US = 50000;
+    // After a bad reply the UART stream is in step again once the line has been quiet this long
+    static const uint32_t RESYNC_QUIET_US = 5000;
+    // Reads failed for good in a row before the rest of the sweep is given up
+    static const uint8_t RECOVERY_MAX_FAILURES = 3;
+    // Most sweeps a chip that gives no valid reply sits out in a row
+    static const uint8_t RECOVERY_MAX_SKIPPED_SWEEPS = 64;
+    // Size of a reply: three data bytes and the checksum
+    static const size_t REPLY_SIZE = sizeof(DataPacket) - 1;
+
+    // Main loop: an asynchronous request/response state machine. Read commands are sent,
+    // loop() returns, and replies are collected on later calls once available() has them.
+    // In UART mode up to pipeline_depth_ reads are outstanding at once; their replies arrive
+    // in command order and are matched to the in-flight queue by position and checksum.
+    // Work continues within one call only while the loop budget lasts. The time each call
+    // blocks the main loop goes to the diagnostics.
+    template <typename Transport>
+    void BL0910Core<Transport>::loop()
+    {
+      if (this->hub_ != nullptr)
+      {
+        return;
+      }
+      uint32_t start = micros();
+      do
+      {
+        if (!Transport::SPI_FRAMING && this->inflight_count_ > 0 && this->receive_reply_())
+          continue;
+        if (this->inflight_count_ < this->pipeline_depth_ && this->issue_next_())
+          continue;
+        // Idle tasks only run once the sweep is done, retries included, and no reply is outstanding
+        if (this->inflight_count_ == 0 && this->sweep_index_ >= this->schedule_size_ &&
+            this->recovery_.queued == 0 && !this->recovery_.resyncing)
+        {
+          this->end_sweep_();
+          this->run_idle_task_();
+        }
+        // Waiting for replies, or the sweep is done
+        break;
+      } while (micros() - start < this->loop_budget_us_);
+      this->diagnostics_.add_loop_time(micros() - start);
+    }
+
+    // Advance the schedule by one step: send the next read, or the rest of a register group in SPI
+    // burst mode. Returns false when there is nothing to do until replies come in or the next update().
+    // A due overload watch pass goes first, between register groups or between sweeps.
+    template <typename Transport>
+    bool BL0910Core<Transport>::issue_next_()
+    {
+      // After a bad reply nothing goes out until the stream is in step again
+      if (this->recovery_.resyncing && !this->resync_done_())
+      {
+        return false;
+      }
+      this->skip_unselected_();
+      bool group_boundary = this->sweep_index_ == 0 || this->sweep_index_ >= this->schedule_size_ ||
+                            this->schedule_[this->sweep_index_ - 1].last_in_channel;
+      if (this->watch_index_ >= this->watch_size_ && group_boundary && this->watch_due_())
+      {
+        this->watch_index_ = 0;
+        this->last_watch_ = micros();
+      }
+      if (this->watch_index_ < this->watch_size_)
+      {
+        if constexpr (Transport::SPI_FRAMING)
+        {
+          this->watch_index_ += this->read_spi_frames_(&this->watch_[this->watch_index_]);
+        }
+        else
+        {
+          this->send_request_(this->watch_[this->watch_index_++]);
+        }
+        return true;
+      }
+      // Queued commands run between register groups or after the sweep, once no reply is
+      // outstanding: they wait for one register group at most
+      if (group_boundary && !this->commands_.empty())
+      {
+        if (this->inflight_count_ > 0)
+        {
+          return false;
+        }
+        this->handle_commands_();
+      }
+      // UART reads that failed go again ahead of the rest of the sweep, oldest first
+      if (this->recovery_.queued > 0)
+      {
+        ReadStep step = this->recovery_.queue[0];
+        this->recovery_.queued--;
+        memmove(this->recovery_.queue, this->recovery_.queue + 1, this->recovery_.queued * sizeof(ReadStep));
+        this->send_request_(step);
+        return true;
+      }
+      // All reads issued, the sweep is done
+      if (this->sweep_index_ >= this->schedule_size_)
+      {
+        return false;
+      }
+      if constexpr (Transport::SPI_FRAMING)
+      {
+        uint8_t count = this->read_spi_frames_(&this->schedule_[this->sweep_index_]);
+        // A sweep given up on is already at its end
+        this->sweep_index_ = std::min<uint8_t>(this->sweep_index_ + count, this->schedule_size_);
+      }
+      else
+      {
+        this->send_request_(this->schedule_[this->sweep_index_++]);
+      }
+      return true;
+    }
+
+    // The line voltage register, also read ahead of a channel's current and power in snapshot mode
+    static constexpr const RegisterDescriptor &VOLTAGE_REGISTER = BL0910_REGISTERS[bl0910_register_index(SensorSlot::VOLTAGE)];
+
+    // Build the polling schedule: the table registers of channels in the channel mask that have a
+    // sensor, feed a derived value or are summarised, grouped as in the table. Nothing else is ever read.
+    void BL0910::build_schedule_()
+    {
+      // Channels with power factor or apparent power, derived from V, I and P
+      uint16_t derived = 0;
+      for (uint8_t i = 0; i < BL0910_CHANNEL_COUNT; i++)
+      {
+        if (this->channels_.sensors[(uint8_t) ChannelSlot::POWER_FACTOR][i] != nullptr ||
+            this->channels_.sensors[(uint8_t) ChannelSlot::APPARENT_POWER][i] != nullptr)
+        {
+          derived |= 1 << (i + 1);
+        }
+      }
+      derived &= this->channel_mask_;
+
+      this->schedule_size_ = 0;
+      uint8_t group_start = 0;
+      for (uint8_t i = 0; i < BL0910_REGISTER_COUNT; i++)
+      {
+        const RegisterDescriptor &reg = BL0910_REGISTERS[i];
+        if (this->channel_mask_ & (1 << reg.channel))
+        {
+          bool derives = derived & (1 << reg.channel);
+          if (derives && this->snapshot_sampling_ && this->schedule_size_ == group_start)
+          {
+            // Internal only, the voltage sensor is fed by the chip-wide read
+            this->schedule_[this->schedule_size_++] = ReadStep{&VOLTAGE_REGISTER, nullptr, false, reg.channel};
+          }
+          sensor::Sensor *sensor = this->sensor_for_(reg);
+          bool summarised = reg.channel != 0 && (this->statistics_.slots[reg.channel - 1] & (1 << (uint8_t) reg.slot));
+          bool needed = sensor != nullptr || summarised ||
+                        (derives && (reg.slot == SensorSlot::CURRENT || reg.slot == SensorSlot::POWER)) ||
+                        (reg.slot == SensorSlot::VOLTAGE && derived != 0 && !this->snapshot_sampling_);
+          if (needed)
+          {
+            this->schedule_[this->schedule_size_++] = ReadStep{&reg, sensor, false, reg.channel};
+          }
+        }
+        bool group_end = i + 1 == BL0910_REGISTER_COUNT || BL0910_REGISTERS[i + 1].channel != reg.channel;
+        if (group_end && this->schedule_size_ > group_start)
+        {
+          this->schedule_[this->schedule_size_ - 1].last_in_channel = true;
+          group_start = this->schedule_size_;
+        }
+      }
+      for (uint8_t i = 0; i < this->schedule_size_; i++)
+      {
+        this->groups_[this->schedule_[i].group].reads++;
+      }
+    }
+
+    // The overload watch: the current and power registers of every channel with a limit, grouped
+    // by channel like the schedule, so an SPI burst never holds more than one register group
+    void BL0910::build_watch_()
+    {
+      this->watch_size_ = 0;
+      for (uint8_t i = 0; i < BL0910_REGISTER_COUNT; i++)
+      {
+        const RegisterDescriptor &reg = BL0910_REGISTERS[i];
+        uint8_t slot = (uint8_t) reg.slot;
+        if (reg.channel != 0 && slot < WATCH_SLOT_COUNT && !std::isnan(this->limits_[slot][reg.channel - 1].threshold))
+        {
+          if (this->watch_size_ > 0 && this->watch_[this->watch_size_ - 1].reg->channel != reg.channel)
+          {
+            this->watch_[this->watch_size_ - 1].last_in_channel = true;
+          }
+          this->watch_[this->watch_size_++] = ReadStep{&reg, nullptr, false, reg.channel, true};
+        }
+      }
+      if (this->watch_size_ > 0)
+      {
+        this->watch_[this->watch_size_ - 1].last_in_channel = true;
+      }
+      this->watch_index_ = this->watch_size_;
+    }
+
+    bool BL0910::watch_due_() const
+    {
+      return this->watch_size_ > 0 && !this->recovery_.skipping && micros() - this->last_watch_ >= this->watch_interval_us_;
+    }
+
+    // Trip a channel limit on the way up, re-arm it once the value is back below its release level
+    void BL0910::check_limit_(uint8_t index, uint8_t slot, float value)
+    {
+      WatchLimit &limit = this->limits_[slot][index];
+      if (std::isnan(limit.threshold) || std::isnan(value))
+      {
+        return;
+      }
+      // Exported power overloads the circuit just the same
+      float magnitude = std::fabs(value);
+      if (limit.tripped)
+      {
+        limit.tripped = magnitude >= limit.release;
+        return;
+      }
+      if (magnitude <= limit.threshold)
+      {
+        return;
+      }
+      limit.tripped = true;
+      if (slot == (uint8_t) ChannelSlot::CURRENT)
+      {
+        ESP_LOGW(TAG, "Channel %u overcurrent: %.3f A", index + 1, value);
+        this->overcurrent_callback_.call(index + 1, value);
+      }
+      else
+      {
+        ESP_LOGW(TAG, "Channel %u overpower: %.1f W", index + 1, value);
+        this->overpower_callback_.call(index + 1, value);
+      }
+    }
+
+    // Skip the register groups not selected for this sweep, they are whole so group boundaries hold
+    void BL0910::skip_unselected_()
+    {
+      while (this->sweep_index_ < this->schedule_size_ &&
+             !(this->sweep_groups_ & (1 << this->schedule_[this->sweep_index_].group)))
+      {
+        this->sweep_index_++;
+      }
+    }
+
+    // The reads of a complete sweep in schedule order, for a hub that sends them as one transaction
+    size_t BL0910::collect_sweep_steps_(ReadStep *steps, size_t max, bool skip_voltage, bool skip_frequency)
+    {
+      size_t count = 0;
+      for (uint8_t i = 0; i < this->schedule_size_ && count < max; i++)
+      {
+        const ReadStep &step = this->schedule_[i];
+        if (!(this->sweep_groups_ & (1 << step.group)))
+        {
+          continue;
+        }
+        // Snapshot voltage reads belong to their channel and are never shared
+        bool snapshot_voltage = this->snapshot_sampling_ && step.sensor == nullptr;
+        if ((skip_voltage && step.reg->slot == SensorSlot::VOLTAGE && !snapshot_voltage) ||
+            (skip_frequency && step.reg->slot == SensorSlot::FREQUENCY))
+        {
+          // Keep the group boundary of a skipped read
+          if (step.last_in_channel && count > 0)
+          {
+            steps[count - 1].last_in_channel = true;
+          }
+          continue;
+        }
+        steps[count++] = step;
+      }
+      return count;
+    }
+
+    // Sensor fed by a register, nullptr if it is not configured
+    sensor::Sensor *BL0910::sensor_for_(const RegisterDescriptor &reg) const
+    {
+      switch (reg.slot)
+      {
+      case SensorSlot::CURRENT:
+      case SensorSlot::POWER:
+      case SensorSlot::ENERGY:
+        return this->channels_.sensors[(uint8_t) reg.slot][reg.channel - 1];
+      case SensorSlot::TEMPERATURE:
+        return this->temperature_sensor_;
+      case SensorSlot::FREQUENCY:
+        return this->frequency_sensor_;
+      case SensorSlot::VOLTAGE:
+        return this->voltage_sensor_;
+      case SensorSlot::TOTAL_POWER:
+        return this->total_power_sensor_;
+      case SensorSlot::TOTAL_ENERGY:
+        return this->total_energy_sensor_;
+      }
+      return nullptr;
+    }
+
+    // All replies of a channel are in: derive values that need the whole channel
+    void BL0910::finish_channel_(uint8_t channel)
+    {
+      if (channel == 0)
+      {
+        return;
+      }
+      this->derive_channel_power_(channel - 1);
+    }
+
+    // Initialization setup function
+    void BL0910::setup()
+    {
+      ESP_LOGCONFIG(TAG, "Setting up BL0910...");
+      // Removed CS pin setup for SPI mode, SPIDevice::spi_setup() handles it.
+      this->build_schedule_();
+      this->build_watch_();
+      this->start_data_rate_tuning_();
+      if (this->telemetry_enabled_)
+      {
+        this->telemetry_.reserve();
+      }
+      if (this->trace_capacity_ != 0)
+      {
+        this->trace_.attach(new TraceRecord[this->trace_capacity_], this->trace_capacity_); // NOLINT(cppcoreguidelines-owning-memory)
+      }
+      if (this->restore_energy_)
+      {
+        this->energy_pref_ = global_preferences->make_preference<EnergyStore>(this->energy_key_, true);
+        if (this->energy_pref_.load(&this->energy_))
+        {
+          ESP_LOGD(TAG, "Restored energy, total %.3f kWh", this->energy_.pulses[BL0910_CHANNEL_COUNT] * BL0910_CF);
+        }
+      }
+      // Calibration registers do not survive a power cycle, restore them in one burst
+      if (this->calibration_key_ != 0)
+      {
+        this->calibration_pref_ = global_preferences->make_preference<CalibrationStore>(this->calibration_key_, true);
+        if (this->calibration_pref_.load(&this->calibration_))
+        {
+          this->calibration_dirty_ = this->calibrated_registers_();
+          this->apply_calibration_();
+        }
+      }
+      this->last_energy_save_ = millis();
+      this->statistics_start_ = this->last_energy_save_;
+      this->diagnostics_start_ = this->last_energy_save_;
+      this->last_sweep_start_ = this->last_energy_save_;
+      if (this->waveform_channel_ != 0)
+      {
+        this->waveform_.attach(new int32_t[this->waveform_samples_], this->waveform_samples_); // NOLINT(cppcoreguidelines-owning-memory)
+        // First capture once the first sweep is done
+        this->last_capture_ = this->last_energy_save_ - this->waveform_interval_;
+      }
+      this->waveform_segment_ = this->waveform_segments_;
+    }
+
+    // Reset the current channel count to trigger the next data reading cycle
+    void BL0910::update()
+    {
+      if (this->hub_ != nullptr)
+      {
+        return;
+      }
+      // Reads still in flight complete on their own, only the schedule restarts
+      this->start_sweep_();
+    }
+
+    // Restart the schedule, readings of the previous sweep no longer count as fresh.
+    // A chip sitting out sweeps after giving no valid reply reads nothing in this one.
+    void BL0910::start_sweep_()
+    {
+      uint32_t now = millis();
+      this->sweep_period_ = now - this->last_sweep_start_;
+      this->last_sweep_start_ = now;
+      if (this->adaptive_)
+      {
+        // Channels first, the chip-wide group follows their activity
+        for (uint8_t group = BL0910_GROUP_COUNT; group-- > 0;)
+        {
+          if (this->sweep_groups_ & (1 << group))
+          {
+            this->adapt_group_(group);
+          }
+        }
+      }
+      ReadRecovery &recovery = this->recovery_;
+      recovery.skipping = recovery.skip_sweeps > 0;
+      if (recovery.skipping)
+      {
+        recovery.skip_sweeps--;
+        this->sweep_groups_ = 0;
+      }
+      else if (this->adaptive_)
+      {
+        this->select_groups_(now);
+      }
+      else
+      {
+        this->sweep_groups_ = 0xFFFF;
+      }
+      // Retries of the previous sweep are stale, its budget does not carry over
+      recovery.retries_left = recovery.budget;
+      recovery.queued = 0;
+      recovery.failures_in_row = 0;
+      recovery.replies = 0;
+      recovery.failures = 0;
+      this->sweep_index_ = 0;
+      memset(this->channels_.fresh, 0, sizeof(this->channels_.fresh));
+      this->save_energy_(false);
+      this->publish_statistics_(now);
+      this->publish_diagnostics_(now);
+      if (this->tuning_.enabled)
+      {
+        this->tune_data_rate_(now);
+      }
+      if (this->telemetry_enabled_)
+      {
+        this->telemetry_.begin(this->telemetry_chip_, now);
+      }
+      this->diagnostics_.sweep_start = micros();
+      this->diagnostics_.sweep_running = true;
+    }
+
+    // The last reply of the sweep is in
+    void BL0910::end_sweep_()
+    {
+      if (!this->diagnostics_.sweep_running)
+      {
+        return;
+      }
+      this->diagnostics_.sweep_running = false;
+      this->diagnostics_.sweeps++;
+      this->diagnostics_.last_sweep_us = micros() - this->diagnostics_.sweep_start;
+      if (this->diagnostics_.last_sweep_us > this->diagnostics_.max_sweep_us)
+      {
+        this->diagnostics_.max_sweep_us = this->diagnostics_.last_sweep_us;
+      }
+      // One frame with every reading of the sweep, none for a sweep that read nothing
+      if (this->telemetry_enabled_ && this->telemetry_.count() > 0)
+      {
+        this->telemetry_.finish(this->telemetry_sequence_++);
+        const std::vector<uint8_t> &frame = this->telemetry_.data();
+        this->telemetry_callback_.call(frame.data(), frame.size());
+      }
+
+      // A chip that gave no valid reply sits out 1, 2, 4... sweeps, each sweep after that probes it
+      ReadRecovery &recovery = this->recovery_;
+      if (recovery.replies > 0)
+      {
+        if (recovery.silent_sweeps > 0)
+        {
+          ESP_LOGI(TAG, "Chip is responding again after %u silent sweeps", recovery.silent_sweeps);
+          recovery.silent_sweeps = 0;
+        }
+      }
+      else if (recovery.failures > 0)
+      {
+        if (recovery.silent_sweeps < 255)
+        {
+          recovery.silent_sweeps++;
+        }
+        recovery.skip_sweeps = 1 << std::min<uint8_t>(recovery.silent_sweeps - 1, 6);
+        if (recovery.skip_sweeps > RECOVERY_MAX_SKIPPED_SWEEPS)
+        {
+          recovery.skip_sweeps = RECOVERY_MAX_SKIPPED_SWEEPS;
+        }
+        if (recovery.silent_sweeps == 1)
+        {
+          ESP_LOGW(TAG, "No valid reply in a sweep, backing off");
+        }
+      }
+    }
+
+    // A failed read may go again while the sweep's retry budget lasts and the sweep goes on
+    bool BL0910::take_retry_()
+    {
+      if (this->recovery_.retries_left == 0 || this->recovery_.failures_in_row >= RECOVERY_MAX_FAILURES)
+      {
+        return false;
+      }
+      this->recovery_.retries_left--;
+      this->diagnostics_.retries++;
+      return true;
+    }
+
+    // UART: queue a read to go out again ahead of the rest of the sweep. Watch reads are not retried,
+    // the next pass comes soon enough.
+    bool BL0910::queue_retry_(const ReadStep &step)
+    {
+      if (step.watch || this->recovery_.queued >= MAX_PIPELINE_DEPTH || !this->take_retry_())
+      {
+        return false;
+      }
+      this->recovery_.queue[this->recovery_.queued++] = step;
+      return true;
+    }
+
+    void BL0910::note_reply_(const ReadStep &step)
+    {
+      // Watch reads run between the sweep's reads and say nothing about its progress
+      if (step.watch)
+      {
+        return;
+      }
+      this->recovery_.replies++;
+      this->recovery_.failures_in_row = 0;
+    }
+
+    // A read failed for good. After too many in a row the chip is not answering, the rest of the
+    // sweep is given up. A failed watch read is only counted, the next watch pass reads it again.
+    void BL0910::note_failure_(const ReadStep &step)
+    {
+      if (step.watch)
+      {
+        this->diagnostics_.watch_failures++;
+        return;
+      }
+      ReadRecovery &recovery = this->recovery_;
+      recovery.failures++;
+      if (recovery.failures_in_row >= RECOVERY_MAX_FAILURES)
+      {
+        return;
+      }
+      if (++recovery.failures_in_row == RECOVERY_MAX_FAILURES)
+      {
+        ESP_LOGW(TAG, "%u reads in a row failed, giving up on this sweep", RECOVERY_MAX_FAILURES);
+        this->sweep_index_ = this->schedule_size_;
+        recovery.queued = 0;
+      }
+    }
+
+    // Smallest change that counts as activity, below it readings are noise
+    static const float ADAPTIVE_POWER_FLOOR = 1.0f;     // W
+    static const float ADAPTIVE_CURRENT_FLOOR = 0.01f;  // A
+    static const float ADAPTIVE_VOLTAGE_FLOOR = 1.0f;   // V
+
+    // Adapt a group's poll interval to what its reads in the previous sweep showed: a change brings
+    // it back to every sweep, a steady reading doubles its interval up to the staleness limit.
+    // A group whose reads did not all come in keeps its interval.
+    void BL0910::adapt_group_(uint8_t group)
+    {
+      GroupPolling &polling = this->groups_[group];
+      if (polling.reads == 0)
+      {
+        return;
+      }
+      float value = NAN;
+      float floor = 0;
+      bool changed = false;
+      if (group == 0)
+      {
+        // Total power and energy follow the channels
+        value = this->voltage_;
+        floor = ADAPTIVE_VOLTAGE_FLOOR;
+        changed = this->channel_activity_;
+        this->channel_activity_ = false;
+      }
+      else
+      {
+        uint8_t index = group - 1;
+        uint8_t fresh = this->channels_.fresh[index];
+        if (fresh & (1 << (uint8_t) ChannelSlot::POWER))
+        {
+          value = this->channels_.values[(uint8_t) ChannelSlot::POWER][index];
+          floor = ADAPTIVE_POWER_FLOOR;
+        }
+        else if (fresh & (1 << (uint8_t) ChannelSlot::CURRENT))
+        {
+          value = this->channels_.values[(uint8_t) ChannelSlot::CURRENT][index];
+          floor = ADAPTIVE_CURRENT_FLOOR;
+        }
+        else if (fresh == 0)
+        {
+          return;
+        }
+      }
+      if (!std::isnan(value))
+      {
+        if (!std::isnan(polling.last_value))
+        {
+          float delta = std::fabs(value - polling.last_value);
+          changed |= delta > floor && delta > this->change_ratio_ * std::max(std::fabs(value), std::fabs(polling.last_value));
+        }
+        polling.last_value = value;
+      }
+      if (changed)
+      {
+        polling.interval = 0;
+        if (group != 0)
+        {
+          this->channel_activity_ = true;
+        }
+      }
+      else
+      {
+        polling.interval = std::min(std::max(polling.interval, this->sweep_period_) * 2, this->max_staleness_);
+      }
+    }
+
+    // Pick the groups of this sweep: those whose interval is up, most overdue first, within the read
+    // budget. A group that would exceed the staleness limit by waiting another sweep goes first.
+    void BL0910::select_groups_(uint32_t now)
+    {
+      // Sweeps are not aligned to the intervals, a group is due once less than half a sweep period remains
+      uint32_t slack = this->sweep_period_ / 2;
+      uint16_t budget = this->max_reads_per_sweep_ == 0 ? UINT16_MAX : this->max_reads_per_sweep_;
+      uint16_t selected = 0;
+      while (true)
+      {
+        uint8_t best = BL0910_GROUP_COUNT;
+        float best_urgency = 0;
+        for (uint8_t group = 0; group < BL0910_GROUP_COUNT; group++)
+        {
+          const GroupPolling &polling = this->groups_[group];
+          uint32_t age = now - polling.last_read;
+          if (polling.reads == 0 || polling.reads > budget || (selected & (1 << group)) || age + slack < polling.interval)
+          {
+            continue;
+          }
+          float urgency = (float) age / std::max<uint32_t>(std::max(polling.interval, this->sweep_period_), 1);
+          if (age + this->sweep_period_ > this->max_staleness_)
+          {
+            urgency += 1e6f;
+          }
+          if (urgency >= best_urgency)
+          {
+            best = group;
+            best_urgency = urgency;
+          }
+        }
+        if (best == BL0910_GROUP_COUNT)
+        {
+          break;
+        }
+        selected |= 1 << best;
+        budget -= this->groups_[best].reads;
+        this->groups_[best].last_read = now;
+      }
+      this->sweep_groups_ = selected;
+    }
+
+    // Close the statistics window at the sweep nearest its end: publish every summary and start
+    // the next window. Sweeps are not aligned to the window, so it closes once less than half a
+    // sweep period remains.
+    void BL0910::publish_statistics_(uint32_t now)
+    {
+      if (now - this->statistics_start_ + this->sweep_period_ / 2 < this->statistics_window_)
+      {
+        return;
+      }
+      this->statistics_start_ = now;
+      for (uint8_t index = 0; index < BL0910_CHANNEL_COUNT; index++)
+      {
+        if (this->statistics_.slots[index] == 0)
+        {
+          continue;
+        }
+        for (uint8_t slot = 0; slot < STAT_SLOT_COUNT; slot++)
+        {
+          RunningStats &stats = this->statistics_.stats[slot][index];
+          for (uint8_t kind = 0; kind < STAT_KIND_COUNT; kind++)
+          {
+            sensor::Sensor *sensor = this->statistics_.sensors[slot][kind][index];
+            if (sensor != nullptr)
+            {
+              // Unknown if no reading made it through in this window
+              this->publish_(sensor, stats.get((StatKind) kind));
+            }
+          }
+          stats = RunningStats{};
+        }
+      }
+    }
+
+    // Publish the bus health once per diagnostics interval and start the next loop() time window
+    void BL0910::publish_diagnostics_(uint32_t now)
+    {
+      if (now - this->diagnostics_start_ < this->diagnostics_interval_)
+      {
+        return;
+      }
+      this->diagnostics_start_ = now;
+      const BusDiagnostics &diagnostics = this->diagnostics_;
+      const DurationHistogram &loop_time = diagnostics.loop_time;
+      // Times in ms, unknown if no loop() call was timed in the window
+      float loop_scale = loop_time.total == 0 ? NAN : 0.001f;
+      const float values[DIAGNOSTIC_SLOT_COUNT] = {
+          (float) diagnostics.frames,
+          (float) diagnostics.bytes,
+          (float) diagnostics.checksum_errors,
+          (float) diagnostics.timeouts,
+          (float) diagnostics.retries,
+          (float) diagnostics.discarded_reads,
+          loop_time.percentile(0.5f) * loop_scale,
+          loop_time.percentile(0.99f) * loop_scale,
+          loop_time.max * loop_scale,
+          diagnostics.last_sweep_us / 1000.0f,
+          this->bus_rate_ == 0 ? NAN : this->bus_rate_ / 1000.0f,
+      };
+      for (uint8_t slot = 0; slot < DIAGNOSTIC_SLOT_COUNT; slot++)
+      {
+        if (this->diagnostic_sensors_[slot] != nullptr)
+        {
+          this->publish_(this->diagnostic_sensors_[slot], values[slot]);
+        }
+      }
+      this->diagnostics_.loop_time = DurationHistogram{};
+    }
+
+    // Clock rates the tuner steps through, as the SPI component accepts them
+    static const uint32_t SPI_DATA_RATES[] = {200000, 1000000, 2000000, 4000000, 5000000, 8000000, 10000000, 20000000};
+    // A window has at least this many frames, and enough to allow this many errors
+    static const uint32_t TUNING_MIN_FRAMES = 1000;
+    static const float TUNING_WINDOW_ERRORS = 3.0f;
+    // A rate that failed is retried after this long at first, twice as long after each failure
+    static const uint32_t TUNING_HOLDOFF_MS = 10 * 60 * 1000;
+    static const uint32_t TUNING_MAX_HOLDOFF_MS = 24 * 60 * 60 * 1000;
+
+    // Start tuning from the configured rate, brought within the tuning range
+    void BL0910::start_data_rate_tuning_()
+    {
+      if (!this->tuning_.enabled)
+      {
+        return;
+      }
+      if (this->bus_rate_ == 0)
+      {
+        ESP_LOGW(TAG, "Data rate tuning needs SPI");
+        this->tuning_.enabled = false;
+        return;
+      }
+      uint32_t rate = std::min(std::max(this->bus_rate_, this->tuning_.min_rate), this->tuning_.max_rate);
+      if (rate != this->bus_rate_)
+      {
+        this->change_data_rate_(rate);
+      }
+    }
+
+    // Once per sweep, judged on the frames since the last change. A full window within the error
+    // budget moves up one rate, and the budget running out at any point moves down one at once.
+    void BL0910::tune_data_rate_(uint32_t now)
+    {
+      DataRateTuning &tuning = this->tuning_;
+      uint32_t frames = this->diagnostics_.frames - tuning.window_frames;
+      uint32_t errors = this->diagnostics_.checksum_errors - tuning.window_errors;
+      uint32_t window = std::max<uint32_t>(TUNING_MIN_FRAMES, std::ceil(TUNING_WINDOW_ERRORS / tuning.max_error_rate));
+      float budget = tuning.max_error_rate * window;
+      if (errors > budget)
+      {
+        tuning.failed_rate = this->bus_rate_;
+        tuning.holdoff = tuning.holdoff == 0 ? TUNING_HOLDOFF_MS : std::min(tuning.holdoff * 2, TUNING_MAX_HOLDOFF_MS);
+        tuning.retry_at = now + tuning.holdoff;
+        uint32_t lower = tuning.min_rate;
+        for (uint32_t rate : SPI_DATA_RATES)
+        {
+          if (rate < this->bus_rate_ && rate > lower)
+          {
+            lower = rate;
+          }
+        }
+        ESP_LOGW(TAG, "%u checksum errors in %u frames at %u kHz, data rate down to %u kHz for %u min", errors, frames,
+                 this->bus_rate_ / 1000, lower / 1000, tuning.holdoff / 60000);
+        this->change_data_rate_(lower);
+        return;
+      }
+      if (frames < window)
+      {
+        return;
+      }
+      // The rate that failed last has held for a whole window, forget the failure
+      if (this->bus_rate_ == tuning.failed_rate)
+      {
+        tuning.failed_rate = 0;
+        tuning.holdoff = 0;
+      }
+      uint32_t higher = 0;
+      for (uint32_t rate : SPI_DATA_RATES)
+      {
+        if (rate > this->bus_rate_ && rate <= tuning.max_rate)
+        {
+          higher = rate;
+          break;
+        }
+      }
+      if (higher != 0 && (higher != tuning.failed_rate || (int32_t) (now - tuning.retry_at) >= 0))
+      {
+        ESP_LOGI(TAG, "%u checksum errors in %u frames at %u kHz, data rate up to %u kHz", errors, frames,
+                 this->bus_rate_ / 1000, higher / 1000);
+        this->change_data_rate_(higher);
+        return;
+      }
+      // Start a new window at the same rate
+      this->change_data_rate_(this->bus_rate_);
+    }
+
+    // Switch the bus clock and start a new evaluation window
+    void BL0910::change_data_rate_(uint32_t rate)
+    {
+      if (rate != this->bus_rate_)
+      {
+        this->set_bus_rate_(rate);
+        this->bus_rate_ = rate;
+      }
+      this->tuning_.window_frames = this->diagnostics_.frames;
+      this->tuning_.window_errors = this->diagnostics_.checksum_errors;
+    }
+
+    // Whether a waveform segment should be captured now, starting a new capture once the interval has passed
+    bool BL0910::waveform_due_()
+    {
+      if (this->waveform_channel_ == 0)
+      {
+        return false;
+      }
+      if (this->waveform_segment_ < this->waveform_segments_)
+      {
+        return true;
+      }
+      uint32_t now = millis();
+      if (now - this->last_capture_ < this->waveform_interval_)
+      {
+        return false;
+      }
+      this->start_capture_();
+      return true;
+    }
+
+    void BL0910::start_capture_()
+    {
+      this->last_capture_ = millis();
+      this->waveform_segment_ = 0;
+      this->harmonics_.reset();
+    }
+
+    // Whether a calibrated register is due to be read back
+    bool BL0910::verify_due_() const
+    {
+      return this->verify_interval_ != 0 && this->calibrated_registers_() != 0 &&
+             millis() - this->last_verify_ >= this->verify_interval_;
+    }
+
+    // Add the captured segment to the harmonic analysis, and publish once the last segment is in
+    void BL0910::analyse_segment_(float sample_rate, float fundamental)
+    {
+      if (!this->harmonics_.add(this->waveform_, sample_rate, fundamental, this->max_harmonic_))
+      {
+        ESP_LOGD(TAG, "Waveform segment of %u samples at %.0f Hz holds no full %.1f Hz cycle", this->waveform_.size(),
+                 sample_rate, fundamental);
+      }
+      if (++this->waveform_segment_ < this->waveform_segments_)
+      {
+        return;
+      }
+      HarmonicResult result = this->harmonics_.result();
+      if (result.count == 0)
+      {
+        ESP_LOGW(TAG, "Waveform capture failed, last sample rate %.0f Hz", sample_rate);
+      }
+      if (this->thd_sensor_ != nullptr)
+      {
+        this->publish_(this->thd_sensor_, result.thd * 100.0f);
+      }
+      for (uint8_t order = 2; order <= WAVEFORM_MAX_HARMONIC; order++)
+      {
+        if (this->harmonic_sensors_[order] != nullptr)
+        {
+          this->publish_(this->harmonic_sensors_[order], result.relative(order) * 100.0f);
+        }
+      }
+    }
+
+    void BL0910::on_shutdown()
+    {
+      this->save_energy_(true);
+    }
+
+    // Counter reads further apart than half the counter range are taken as a chip reset, not a wrap
+    // (far more than any load adds between two sweeps)
+    float BL0910::accumulate_energy_(const RegisterDescriptor &reg, uint32_t raw)
+    {
+      uint8_t index = reg.channel == 0 ? BL0910_CHANNEL_COUNT : reg.channel - 1;
+      uint32_t mask = (1UL << reg.width) - 1;
+      uint32_t delta = (raw - this->energy_.counts[index]) & mask;
+      if (this->energy_rebaseline_ & (1 << index))
+      {
+        this->energy_rebaseline_ &= ~(1 << index);
+        delta = 0;
+      }
+      else if (delta > mask / 2)
+      {
+        // The counter went backwards: the chip was reset and counts from zero again
+        if (this->energy_.pulses[index] > 0)
+        {
+          ESP_LOGW(TAG, "Energy counter 0x%02X restarted (%u -> %u)", reg.address, this->energy_.counts[index], raw);
+        }
+        delta = raw;
+      }
+      this->energy_.counts[index] = raw;
+      if (delta > 0)
+      {
+        this->energy_.pulses[index] += delta;
+        this->unsaved_energy_ += delta * reg.scale;
+      }
+      return (float) (this->energy_.pulses[index] * (double) reg.scale);
+    }
+
+    // Zero the accumulated energy, each counter's next read becomes its new baseline
+    void BL0910::clear_energy_()
+    {
+      memset(this->energy_.pulses, 0, sizeof(this->energy_.pulses));
+      this->energy_rebaseline_ = (1 << BL0910_ENERGY_COUNTERS) - 1;
+      this->energy_save_pending_ = true;
+    }
+
+    // Write the accumulated energy to flash once enough is unsaved or the save interval has passed,
+    // so a busy meter does not wear the flash
+    void BL0910::save_energy_(bool force)
+    {
+      if (!this->restore_energy_)
+      {
+        return;
+      }
+      uint32_t now = millis();
+      bool due = this->unsaved_energy_ >= this->energy_save_threshold_ ||
+                 (this->unsaved_energy_ > 0 && now - this->last_energy_save_ >= this->energy_save_interval_);
+      // A pending reset waits for its baselines, or a reboot would count the old counts again
+      bool pending = this->energy_save_pending_ && this->energy_rebaseline_ == 0;
+      if (!due && !pending && !(force && this->unsaved_energy_ > 0))
+      {
+        return;
+      }
+      this->energy_pref_.save(&this->energy_);
+      this->unsaved_energy_ = 0;
+      this->energy_save_pending_ = false;
+      this->last_energy_save_ = now;
+    }
+
+    // Correct a channel's offset or gain in the register shadow, from its latest reading and the
+    // reference it should read. Returns true if a register became dirty.
+    bool BL0910::calibrate_(uint8_t channel, CalibrationKind kind, float reference)
+    {
+      if (channel < 1 || channel > BL0910_CHANNEL_COUNT)
+      {
+        ESP_LOGW(TAG, "Calibration of invalid channel %u", channel);
+        return false;
+      }
+      uint8_t index = channel - 1;
+      ChannelSlot slot = kind == CalibrationKind::POWER_GAIN ? ChannelSlot::POWER : ChannelSlot::CURRENT;
+      float measured = this->channels_.values[(uint8_t) slot][index];
+      if (std::isnan(measured) || (kind != CalibrationKind::CURRENT_OFFSET && measured == 0))
+      {
+        ESP_LOGW(TAG, "Channel %u has no reading to calibrate against", channel);
+        return false;
+      }
+      int32_t &value = this->calibration_.values[(uint8_t) kind][index];
+      int32_t updated = kind == CalibrationKind::CURRENT_OFFSET ? this->bias_correction_(index, measured, reference)
+                                                                : this->gain_correction_(value, measured, reference);
+      ESP_LOGI(TAG, "Channel %u calibration: %.4f read, %.4f expected, register %d", channel, measured, reference, updated);
+      uint32_t bit = 1UL << ((uint8_t) kind * BL0910_CHANNEL_COUNT + index);
+      // The chip already holds this value
+      if (updated == value && !(this->calibration_dirty_ & bit))
+      {
+        return false;
+      }
+      value = updated;
+      this->calibration_dirty_ |= bit;
+      return true;
+    }
+
+    // Current offset that moves a channel's reading from measured to expected. The chip adds
+    // RMSOS * 256 to the squared raw RMS before its gain, so the correction is applied through the
+    // gain and on top of the offset already set.
+    int32_t BL0910::bias_correction_(uint8_t index, float measured, float expected) const
+    {
+      float gain = 1 + this->calibration_.values[(uint8_t) CalibrationKind::CURRENT_GAIN][index] / 65536.0f;
+      float i_rms0 = measured * BL0910_KI / gain;
+      float i_rms = expected * BL0910_KI / gain;
+      int32_t value = this->calibration_.values[(uint8_t) CalibrationKind::CURRENT_OFFSET][index] + (i_rms * i_rms - i_rms0 * i_rms0) / 256;
+      return std::max<int32_t>(-0x800000, std::min<int32_t>(0x7FFFFF, value));
+    }
+
+    // Gain register that moves a reading from measured to expected, the reading scales by 1 + gain / 65536
+    int32_t BL0910::gain_correction_(int32_t gain, float measured, float expected) const
+    {
+      float factor = (1 + gain / 65536.0f) * std::fabs(expected / measured);
+      int32_t value = std::lround((factor - 1) * 65536);
+      return std::max<int32_t>(-0x8000, std::min<int32_t>(0x7FFF, value));
+    }
+
+    // Registers holding a calibration, bit kind * 10 + channel - 1
+    uint32_t BL0910::calibrated_registers_() const
+    {
+      uint32_t registers = 0;
+      for (uint8_t kind = 0; kind < CALIBRATION_KIND_COUNT; kind++)
+      {
+        for (uint8_t index = 0; index < BL0910_CHANNEL_COUNT; index++)
+        {
+          if (this->calibration_.values[kind][index] != 0)
+          {
+            registers |= 1UL << (kind * BL0910_CHANNEL_COUNT + index);
+          }
+        }
+      }
+      return registers;
+    }
+
+    // Reset energy
+    template <typename Transport>
+    void BL0910Core<Transport>::reset_energy_()
+    {
+      this->clear_energy_();
+      if constexpr (Transport::SPI_FRAMING) {
+        // SPI interface reset: send six 0xFF
+        memset(this->spi_frames_, 0xFF, BL0910_FRAME_SIZE);
+        this->transport_()->bus_transfer_(this->spi_frames_, 1);
+        this->diagnostics_.sent(1, BL0910_FRAME_SIZE);
+        ESP_LOGW(TAG, "SPI interface reset with 6×0xFF");
+      } else {
+        // UART initialization sequence
+        this->transport_()->bus_write_(BL0910_INIT[0], 6);
+        this->diagnostics_.sent(1, BL0910_FRAME_SIZE);
+        delay(1);
+        this->transport_()->bus_flush_();
+        ESP_LOGW(TAG, "Device reset with init command.");
+        // The soft reset cleared the calibration registers and write protection
+        this->calibration_dirty_ |= this->calibrated_registers_();
+        this->write_protection_ = -1;
+        this->apply_calibration_();
+      }
+    }
+
+    template <typename Transport>
+    void BL0910Core<Transport>::set_bus_rate_(uint32_t rate)
+    {
+      if constexpr (Transport::SPI_FRAMING)
+      {
+        this->transport_()->bus_set_data_rate_(rate);
+      }
+    }
+
+    template <typename Transport>
+    void BL0910Core<Transport>::transfer_frames_(uint8_t *frames, size_t count)
+    {
+      if constexpr (Transport::SPI_FRAMING)
+      {
+        this->transport_()->bus_transfer_(frames, count);
+        this->diagnostics_.sent(count, count * BL0910_FRAME_SIZE);
+      }
+    }
+
+    template <typename Transport>
+    bool BL0910Core<Transport>::run_idle_task_()
+    {
+      // A chip sitting out sweeps is left alone
+      if (this->recovery_.skipping)
+      {
+        return false;
+      }
+      // A segment is one blocking burst, only SPI is fast enough for it
+      if constexpr (Transport::SPI_FRAMING)
+      {
+        if (this->waveform_due_())
+        {
+          this->capture_segment_();
+          return true;
+        }
+      }
+      if (this->calibration_unverified_ != 0)
+      {
+        this->verify_calibration_();
+        return true;
+      }
+      if (this->verify_due_())
+      {
+        this->verify_shadow_();
+        return true;
+      }
+      return false;
+    }
+
+    // The line frequency register, read ahead of each waveform segment
+    static constexpr const RegisterDescriptor &FREQUENCY_REGISTER = BL0910_REGISTERS[bl0910_register_index(SensorSlot::FREQUENCY)];
+    // Line frequency assumed when the frequency register cannot be read
+    static const float DEFAULT_LINE_FREQUENCY = 50.0f;
+
+    // Capture one waveform segment in a single blocking burst: the line frequency, then the samples
+    // back to back or paced by the sample interval. Paced samples have an exact sample rate, free
+    // running ones the average rate of the burst. SPI only; splitting the burst over several loop()
+    // calls would leave gaps in the samples.
+    template <typename Transport>
+    void BL0910Core<Transport>::capture_segment_()
+    {
+      // Leftovers of an abandoned read would be taken for the first reply
+      this->discard_input_();
+      uint32_t raw;
+      float fundamental = DEFAULT_LINE_FREQUENCY;
+      if (this->read_register_(FREQUENCY_REGISTER.address, raw) && raw != 0)
+      {
+        fundamental = convert_(FREQUENCY_REGISTER, raw);
+      }
+      uint8_t address = this->waveform_channel_ == WAVEFORM_VOLTAGE ? BL0910_WAVE_V : BL0910_WAVE_1 + this->waveform_channel_ - 1;
+      uint32_t interval = this->waveform_sample_interval_us_;
+      this->waveform_.clear();
+      uint32_t start = micros();
+      uint32_t due = start;
+      for (uint16_t i = 0; i < this->waveform_samples_; i++)
+      {
+        if (interval != 0)
+        {
+          while ((int32_t) (micros() - due) < 0)
+          {
+          }
+          due += interval;
+        }
+        if (!this->read_register_(address, raw))
+        {
+          // A gap would shift every later sample, the segment is lost
+          ESP_LOGD(TAG, "Waveform read failed after %u samples", i);
+          this->waveform_.clear();
+          break;
+        }
+        // Sign-extend the 24-bit sample
+        this->waveform_.push((int32_t) (raw << 8) >> 8);
+      }
+      uint32_t elapsed = micros() - start;
+      float sample_rate = interval != 0 ? 1e6f / interval : this->waveform_.size() * 1e6f / std::max<uint32_t>(elapsed, 1);
+      this->analyse_segment_(sample_rate, fundamental);
+    }
+
+    // Read one register outside the schedule and wait for its reply. Only while nothing is in
+    // flight. Returns false on a timeout or a bad checksum.
+    template <typename Transport>
+    bool BL0910Core<Transport>::read_register_(uint8_t address, uint32_t &value)
+    {
+      DataPacket buffer;
+      if constexpr (Transport::SPI_FRAMING)
+      {
+        uint8_t frame[BL0910_FRAME_SIZE] = {BL0910_SPI_READ_COMMAND, address};
+        this->transport_()->bus_transfer_(frame, 1);
+        this->diagnostics_.sent(1, BL0910_FRAME_SIZE);
+        buffer.h = frame[2];
+        buffer.m = frame[3];
+        buffer.l = frame[4];
+        buffer.checksum = frame[5];
+      }
+      else
+      {
+        const uint8_t command[2] = {BL0910_READ_COMMAND, address};
+        this->transport_()->bus_write_(command, sizeof(command));
+        this->diagnostics_.sent(1, sizeof(command));
+        uint32_t sent_at = micros();
+        while (this->transport_()->bus_available_() < (int) REPLY_SIZE)
+        {
+          if (micros() - sent_at >= READ_TIMEOUT_US)
+          {
+            this->diagnostics_.timeouts++;
+            this->record_frame_(TraceKind::TIMEOUT, address, DataPacket{});
+            this->discard_input_();
+            return false;
+          }
+        }
+        if (!this->transport_()->bus_read_((uint8_t *) &buffer, REPLY_SIZE))
+        {
+          this->diagnostics_.timeouts++;
+          this->record_frame_(TraceKind::TIMEOUT, address, DataPacket{});
+          return false;
+        }
+        this->diagnostics_.bytes += REPLY_SIZE;
+      }
+      // Waveform samples would flush the trace within one capture
+      if (address < BL0910_WAVE_1 || address > BL0910_WAVE_V)
+      {
+        this->record_frame_(TraceKind::READ, address, buffer);
+      }
+      if (bl0910_checksum(address, &buffer) != buffer.checksum)
+      {
+        this->diagnostics_.checksum_errors++;
+        return false;
+      }
+      value = to_uint32_t(buffer);
+      return true;
+    }
+
+    // Drop any bytes waiting in the receive buffer
+    template <typename Transport>
+    void BL0910Core<Transport>::discard_input_()
+    {
+      // SPI has no receive buffer, replies are clocked out on demand
+      if constexpr (!Transport::SPI_FRAMING)
+      {
+        uint8_t scratch[16];
+        int pending;
+        while ((pending = this->transport_()->bus_available_()) > 0)
+        {
+          size_t len = std::min<size_t>(pending, sizeof(scratch));
+          this->transport_()->bus_read_(scratch, len);
+          this->diagnostics_.bytes += len;
+        }
+      }
+    }
+
+    // Read registers of the current channel over SPI, each as one full-duplex frame:
+    // 0x82, Addr, then H, M, L, checksum clocked out while dummy bytes are sent.
+    // In burst mode the rest of the channel goes out in a single chip select assertion.
+    // Returns the number of steps read.
+    template <typename Transport>
+    uint8_t BL0910Core<Transport>::read_spi_frames_(const ReadStep *steps)
+    {
+      if constexpr (!Transport::SPI_FRAMING)
+      {
+        // UART reads go through send_request_()
+        return 0;
+      }
+      else
+      {
+        // A group ends at last_in_channel; the cap keeps a malformed list inside spi_frames_
+        uint8_t count = 1;
+        if (this->spi_burst_)
+        {
+          while (!steps[count - 1].last_in_channel && count < BL0910_MAX_GROUP_SIZE)
+          {
+            count++;
+          }
+        }
+        uint8_t *frame = this->spi_frames_;
+        for (uint8_t i = 0; i < count; i++, frame += BL0910_FRAME_SIZE)
+        {
+          memset(frame, 0x00, BL0910_FRAME_SIZE);
+          frame[0] = BL0910_SPI_READ_COMMAND;
+          frame[1] = steps[i].reg->address;
+        }
+        this->transport_()->bus_transfer_(this->spi_frames_, count);
+        this->diagnostics_.sent(count, count * BL0910_FRAME_SIZE);
+        this->process_spi_frames_(this->spi_frames_, steps, count);
+        return count;
+      }
+    }
+
+    // Verify and publish the replies of exchanged SPI read frames
+    void BL0910::process_spi_frames_(const uint8_t *frames, const ReadStep *steps, size_t count)
+    {
+      const uint8_t *frame = frames;
+      for (size_t i = 0; i < count; i++, frame += BL0910_FRAME_SIZE)
+      {
+        const ReadStep &step = steps[i];
+        DataPacket buffer;
+        buffer.h = frame[2];
+        buffer.m = frame[3];
+        buffer.l = frame[4];
+        buffer.checksum = frame[5];
+        this->record_frame_(TraceKind::READ, step.reg->address, buffer);
+        // A bad reply is read again on its own while the sweep's retry budget lasts
+        while (!step.watch && bl0910_checksum(step.reg->address, &buffer) != buffer.checksum && this->take_retry_())
+        {
+          this->diagnostics_.checksum_errors++;
+          ESP_LOGD(TAG, "Checksum failed reading register 0x%02X, reading it again", step.reg->address);
+          uint8_t retry[BL0910_FRAME_SIZE] = {BL0910_SPI_READ_COMMAND, step.reg->address};
+          this->transfer_frames_(retry, 1);
+          buffer.h = retry[2];
+          buffer.m = retry[3];
+          buffer.l = retry[4];
+          buffer.checksum = retry[5];
+          this->record_frame_(TraceKind::READ, step.reg->address, buffer);
+        }
+        if (this->handle_reply_(step, buffer))
+        {
+          this->note_reply_(step);
+        }
+        else
+        {
+          this->note_failure_(step);
+        }
+      }
+    }
+
+    // Route a reply to the overload watch or to the sweep. Returns false if the frame was bad.
+    bool BL0910::handle_reply_(const ReadStep &step, const DataPacket &buffer)
+    {
+      if (step.watch)
+      {
+        if (bl0910_checksum(step.reg->address, &buffer) != buffer.checksum)
+        {
+          this->diagnostics_.checksum_errors++;
+          ESP_LOGW(TAG, "Checksum failed. Discarding message.");
+          return false;
+        }
+        this->check_limit_(step.reg->channel - 1, (uint8_t) step.reg->slot, convert_(*step.reg, to_uint32_t(buffer)));
+        return true;
+      }
+      bool ok = this->read_data_(*step.reg, step.sensor, buffer);
+      if (step.last_in_channel)
+      {
+        this->finish_channel_(step.reg->channel);
+      }
+      return ok;
+    }
+
+    void BL0910::record_frame_(TraceKind kind, uint8_t address, const DataPacket &data)
+    {
+      if (this->trace_.capacity() != 0)
+      {
+        this->trace_.push(TraceRecord{micros(), kind, address, data.h, data.m, data.l, data.checksum});
+      }
+    }
+
+    // Log the recorded frames oldest first, TRACE_LINE_RECORDS per line in their text form, then
+    // start over. The lines can be handed to the emulator's replay as they are.
+    static const uint8_t TRACE_LINE_RECORDS = 8;
+    void BL0910::dump_trace_()
+    {
+      if (this->trace_.capacity() == 0)
+      {
+        ESP_LOGW(TAG, "Trace recording is not configured");
+        return;
+      }
+      ESP_LOGI(TAG, "Trace: %u records, %u overwritten", this->trace_.size(), this->trace_.overwritten());
+      char line[TRACE_LINE_RECORDS * (TRACE_TEXT_SIZE + 1) + 1];
+      for (uint16_t start = 0; start < this->trace_.size(); start += TRACE_LINE_RECORDS)
+      {
+        char *out = line;
+        for (uint16_t i = start; i < this->trace_.size() && i < start + TRACE_LINE_RECORDS; i++)
+        {
+          format_trace_record(this->trace_.at(i), out);
+          out += TRACE_TEXT_SIZE;
+          *out++ = ' ';
+        }
+        out[-1] = '\0';
+        ESP_LOGI(TAG, "TRACE %s", line);
+      }
+      this->trace_.clear();
+    }
+
+    // Send the UART read command for one register, the reply is collected by receive_reply_()
+    template <typename Transport>
+    void BL0910Core<Transport>::send_request_(const ReadStep &step)
+    {
+      if constexpr (Transport::SPI_FRAMING)
+      {
+        // SPI reads go through read_spi_frames_()
         return;
       }
+      else
+      {
+        // Drop leftovers of an abandoned read so they are not taken for this reply
+        if (this->inflight_count_ == 0)
+        {
+          this->discard_input_();
+        }
+        const uint8_t command[2] = {BL0910_READ_COMMAND, step.reg->address};
+        this->transport_()->bus_write_(command, sizeof(command));
+        this->diagnostics_.sent(1, sizeof(command));
+        InFlightRead &read = this->inflight_[(this->inflight_head_ + this->inflight_count_) % MAX_PIPELINE_DEPTH];
+        read.step = step;
+        read.sent_at = micros();
+        this->inflight_count_++;
+      }
+    }
+
+    // A reply was lost or bad, so the replies behind it can no longer be attributed. The failed read
+    // and the reads outstanding behind it go again while the retry budget lasts, once the stream is
+    // re-framed.
+    template <typename Transport>
+    void BL0910Core<Transport>::recover_(const ReadStep &failed)
+    {
+      if (!this->queue_retry_(failed))
+      {
+        this->note_failure_(failed);
+      }
+      for (uint8_t i = 0; i < this->inflight_count_; i++)
+      {
+        const ReadStep &step = this->inflight_[(this->inflight_head_ + i) % MAX_PIPELINE_DEPTH].step;
+        this->record_frame_(TraceKind::DROPPED, step.reg->address, DataPacket{});
+        if (!this->queue_retry_(step))
+        {
+          this->diagnostics_.discarded_reads++;
+        }
+      }
+      this->inflight_count_ = 0;
+      this->recovery_.resyncing = true;
+      this->recovery_.last_byte = micros();
+    }
+
+    // Bytes still arriving belong to replies already given up on: drop them, and wait for the line
+    // to be quiet. Returns true once the stream is in step again.
+    template <typename Transport>
+    bool BL0910Core<Transport>::resync_done_()
+    {
+      if constexpr (!Transport::SPI_FRAMING)
+      {
+        if (this->transport_()->bus_available_() > 0)
+        {
+          this->discard_input_();
+          this->recovery_.last_byte = micros();
+          return false;
+        }
+        if (micros() - this->recovery_.last_byte < RESYNC_QUIET_US)
+        {
+          return false;
+        }
+      }
+      this->recovery_.resyncing = false;
+      return true;
+    }
+
+    // Collect the reply of the oldest outstanding read. Returns false while it is still incomplete.
+    template <typename Transport>
+    bool BL0910Core<Transport>::receive_reply_()
+    {
+      if constexpr (Transport::SPI_FRAMING)
+      {
+        // SPI replies arrive with their command, nothing is ever in flight
+        return false;
+      }
+      else
+      {
+        InFlightRead &read = this->inflight_[this->inflight_head_];
+        bool timed_out = false;
+        if (this->transport_()->bus_available_() < (int) REPLY_SIZE)
+        {
+          if (micros() - read.sent_at < READ_TIMEOUT_US)
+          {
+            return false;
+          }
+          timed_out = true;
+        }
+        ReadStep step = read.step;
+        this->inflight_head_ = (this->inflight_head_ + 1) % MAX_PIPELINE_DEPTH;
+        this->inflight_count_--;
+        if (timed_out)
+        {
+          // Later replies queue behind this one, none of them can be trusted
+          ESP_LOGW(TAG, "Timeout reading register 0x%02X with %u reads outstanding", step.reg->address, this->inflight_count_);
+          this->diagnostics_.timeouts++;
+          this->record_frame_(TraceKind::TIMEOUT, step.reg->address, DataPacket{});
+          this->recover_(step);
+          return true;
+        }
+
+        // Read 3 data bytes + checksum
+        DataPacket buffer;
+        if (!this->transport_()->bus_read_((uint8_t *) &buffer, REPLY_SIZE))
+        {
+          this->diagnostics_.timeouts++;
+          this->record_frame_(TraceKind::TIMEOUT, step.reg->address, DataPacket{});
+          this->recover_(step);
+          return true;
+        }
+        this->diagnostics_.bytes += REPLY_SIZE;
+        this->record_frame_(TraceKind::READ, step.reg->address, buffer);
+        if (this->handle_reply_(step, buffer))
+        {
+          this->note_reply_(step);
+        }
+        else
+        {
+          // A bad frame in a pipelined stream may mean lost bytes, re-frame before going on
+          if (this->inflight_count_ > 0)
+          {
+            ESP_LOGW(TAG, "Bad frame with %u reads outstanding, re-framing the stream", this->inflight_count_);
+          }
+          this->recover_(step);
+        }
+        return true;
+      }
+    }
 
-      this->flush(); // Clear the buffer to avoid interference from residual data
+    // Channel registers keep their slot, chip-wide ones follow the derived quantities
+    static_assert((uint8_t) TelemetryQuantity::CURRENT == (uint8_t) SensorSlot::CURRENT &&
+                      (uint8_t) TelemetryQuantity::ENERGY == (uint8_t) SensorSlot::ENERGY &&
+                      (uint8_t) TelemetryQuantity::TEMPERATURE == (uint8_t) SensorSlot::TEMPERATURE + 2 &&
+                      (uint8_t) TelemetryQuantity::TOTAL_ENERGY == (uint8_t) SensorSlot::TOTAL_ENERGY + 2,
+                  "telemetry quantities must follow the sensor slots");
+    static TelemetryQuantity telemetry_quantity(const RegisterDescriptor &reg)
+    {
+      return (TelemetryQuantity) ((uint8_t) reg.slot + (reg.channel == 0 ? 2 : 0));
+    }
 
-      // Read different sensor data according to the current channel
-      switch (this->current_channel_)
+    // Verify, convert and publish one register reply. Returns false if the frame was bad.
+    bool BL0910::read_data_(const RegisterDescriptor &reg, sensor::Sensor *sensor, const DataPacket &buffer)
+    {
+      if (bl0910_checksum(reg.address, &buffer) != buffer.checksum)
       {
-      case 0:
-        this->read_data_(BL0910_TEMPERATURE, BL0910_TREF, this->temperature_sensor_); // Temperature
-        break;
-      case 1:
-        this->read_data_(BL0910_I_1_RMS, BL0910_IREF, this->current_1_sensor_);
-        this->read_data_(BL0910_WATT_1, BL0910_PREF, this->power_1_sensor_);
-        this->read_data_(BL0910_CF_1_CNT, BL0910_EREF, this->energy_1_sensor_);
-        this->calculate_power_factor_(this->current_1_sensor_, this->voltage_sensor_, this->power_1_sensor_, this->power_factor_1_sensor_);
-        break;
-      case 2:
-        this->read_data_(BL0910_I_2_RMS, BL0910_IREF, this->current_2_sensor_);
-        this->read_data_(BL0910_WATT_2, BL0910_PREF, this->power_2_sensor_);
-        this->read_data_(BL0910_CF_2_CNT, BL0910_EREF, this->energy_2_sensor_);
-        this->calculate_power_factor_(this->current_2_sensor_, this->voltage_sensor_, this->power_2_sensor_, this->power_factor_2_sensor_);
-        break;
-      case 3:
-        this->read_data_(BL0910_I_3_RMS, BL0910_IREF, this->current_3_sensor_);
-        this->read_data_(BL0910_WATT_3, BL0910_PREF, this->power_3_sensor_);
-        this->read_data_(BL0910_CF_3_CNT, BL0910_EREF, this->energy_3_sensor_);
-        this->calculate_power_factor_(this->current_3_sensor_, this->voltage_sensor_, this->power_3_sensor_, this->power_factor_3_sensor_);
-        break;
-      case 4:
-        this->read_data_(BL0910_I_4_RMS, BL0910_IREF, this->current_4_sensor_);
-        this->read_data_(BL0910_WATT_4, BL0910_PREF, this->power_4_sensor_);
-        this->read_data_(BL0910_CF_4_CNT, BL0910_EREF, this->energy_4_sensor_);
-        this->calculate_power_factor_(this->current_4_sensor_, this->voltage_sensor_, this->power_4_sensor_, this->power_factor_4_sensor_);
-        break;
-      case 5:
-        this->read_data_(BL0910_I_5_RMS, BL0910_IREF, this->current_5_sensor_);
-        this->read_data_(BL0910_WATT_5, BL0910_PREF, this->power_5_sensor_);
-        this->read_data_(BL0910_CF_5_CNT, BL0910_EREF, this->energy_5_sensor_);
-        this->calculate_power_factor_(this->current_5_sensor_, this->voltage_sensor_, this->power_5_sensor_, this->power_factor_5_sensor_);
-        break;
-      case 6:
-        this->read_data_(BL0910_I_6_RMS, BL0910_IREF, this->current_6_sensor_);
-        this->read_data_(BL0910_WATT_6, BL0910_PREF, this->power_6_sensor_);
-        this->read_data_(BL0910_CF_6_CNT, BL0910_EREF, this->energy_6_sensor_);
-        this->calculate_power_factor_(this->current_6_sensor_, this->voltage_sensor_, this->power_6_sensor_, this->power_factor_6_sensor_);
-        break;
-      case 7:
-        this->read_data_(BL0910_I_7_RMS, BL0910_IREF, this->current_7_sensor_);
-        this->read_data_(BL0910_WATT_7, BL0910_PREF, this->power_7_sensor_);
-        this->read_data_(BL0910_CF_7_CNT, BL0910_EREF, this->energy_7_sensor_);
-        this->calculate_power_factor_(this->current_7_sensor_, this->voltage_sensor_, this->power_7_sensor_, this->power_factor_7_sensor_);
-        break;
-      case 8:
-        this->read_data_(BL0910_I_8_RMS, BL0910_IREF, this->current_8_sensor_);
-        this->read_data_(BL0910_WATT_8, BL0910_PREF, this->power_8_sensor_);
-        this->read_data_(BL0910_CF_8_CNT, BL0910_EREF, this->energy_8_sensor_);
-        this->calculate_power_factor_(this->current_8_sensor_, this->voltage_sensor_, this->power_8_sensor_, this->power_factor_8_sensor_);
-        break;
-      case 9:
-        this->read_data_(BL0910_I_9_RMS, BL0910_IREF, this->current_9_sensor_);
-        this->read_data_(BL0910_WATT_9, BL0910_PREF, this->power_9_sensor_);
-        this->read_data_(BL0910_CF_9_CNT, BL0910_EREF, this->energy_9_sensor_);
-        this->calculate_power_factor_(this->current_9_sensor_, this->voltage_sensor_, this->power_9_sensor_, this->power_factor_9_sensor_);
-        break;
-      case 10:
-        this->read_data_(BL0910_I_10_RMS, BL0910_IREF, this->current_10_sensor_);
-        this->read_data_(BL0910_WATT_10, BL0910_PREF, this->power_10_sensor_);
-        this->read_data_(BL0910_CF_10_CNT, BL0910_EREF, this->energy_10_sensor_);
-        this->calculate_power_factor_(this->current_10_sensor_, this->voltage_sensor_, this->power_10_sensor_, this->power_factor_10_sensor_);
-        break;
-      case (UINT8_MAX - 2):
-        this->read_data_(BL0910_FREQUENCY, BL0910_FREF, this->frequency_sensor_); // Frequency
-        this->read_data_(BL0910_V_RMS, BL0910_UREF, this->voltage_sensor_);       // Voltage
-        break;
-      case (UINT8_MAX - 1):
-        this->read_data_(BL0910_WATT_SUM, BL0910_WATT, this->total_power_sensor_);  // Total power
-        this->read_data_(BL0910_CF_SUM_CNT, BL0910_CF, this->total_energy_sensor_); // Total Energy
-        break;
-      default:
-        this->current_channel_ = UINT8_MAX - 2; // Go to frequency and voltage
+        this->diagnostics_.checksum_errors++;
+        ESP_LOGW(TAG, "Checksum failed. Discarding message."); // If checksum error, discard data
+        return false;
+      }
+      uint32_t raw = to_uint32_t(buffer);
+      float value = reg.conversion == Conversion::COUNTER ? this->accumulate_energy_(reg, raw) : convert_(reg, raw);
+      if (this->telemetry_enabled_)
+      {
+        this->telemetry_.add(telemetry_quantity(reg), reg.channel, raw, value);
+      }
+      if (reg.channel != 0)
+      {
+        uint8_t slot = (uint8_t) reg.slot;
+        this->channels_.values[slot][reg.channel - 1] = value;
+        this->channels_.fresh[reg.channel - 1] |= 1 << slot;
+        if (this->statistics_.slots[reg.channel - 1] & (1 << slot))
+        {
+          this->statistics_.stats[slot][reg.channel - 1].add(value);
+        }
+        // Regular reads count towards the overload limits too
+        if (slot < WATCH_SLOT_COUNT)
+        {
+          this->check_limit_(reg.channel - 1, slot, value);
+        }
+      }
+      else if (reg.slot == SensorSlot::VOLTAGE)
+      {
+        this->voltage_ = value;
+      }
+      else if (reg.slot == SensorSlot::FREQUENCY)
+      {
+        this->frequency_ = value;
+      }
+      // Reads that only feed derived values have no sensor
+      if (sensor != nullptr)
+      {
+        this->publish_(sensor, value, this->gate_for_(reg));
+      }
+      return true;
+    }
+
+    // Publish policy of the sensor fed by a register, nullptr if it publishes every reading
+    PublishGate *BL0910::gate_for_(const RegisterDescriptor &reg) const
+    {
+      if (reg.channel != 0)
+      {
+        return this->channels_.gates[(uint8_t) reg.slot][reg.channel - 1];
+      }
+      return this->gates_[(uint8_t) reg.slot];
+    }
+
+    // Publish a reading to its sensor, unless its publish policy holds it back
+    void BL0910::publish_(sensor::Sensor *sensor, float value, PublishGate *gate)
+    {
+      if (gate != nullptr && !gate->admit(value, millis()))
+      {
+        this->suppressed_count_++;
         return;
       }
-      // Increment channel and process subsequent operations
-      this->current_channel_++;
-      this->handle_actions_();
+      this->publish_count_++;
+      sensor->publish_state(value);
     }
 
-    // Initialization setup function
-    void BL0910::setup()
+    // Deadbands compare against the last published value, so a slow drift is still published
+    // once it adds up. Unknown (NaN) readings publish as soon as the interval allows, as does
+    // the first reading and the return from unknown.
+    bool PublishGate::admit(float value, uint32_t now)
     {
-      ESP_LOGCONFIG(TAG, "Setting up BL0910...");
-      // Removed CS pin setup for SPI mode, SPIDevice::spi_setup() handles it.
+      uint32_t elapsed = now - this->last_time;
+      if (this->published && elapsed < this->policy.min_interval_ms)
+      {
+        return false;
+      }
+      bool due = !this->published || (this->policy.max_interval_ms != 0 && elapsed >= this->policy.max_interval_ms);
+      bool changed;
+      if (std::isnan(value) || std::isnan(this->last_value))
+      {
+        changed = std::isnan(value) != std::isnan(this->last_value);
+      }
+      else if (this->policy.deadband > 0 || this->policy.deadband_ratio > 0)
+      {
+        // A relative deadband around zero is zero wide, an unchanged value still stays held back
+        float threshold = std::max(this->policy.deadband, std::fabs(this->last_value) * this->policy.deadband_ratio);
+        changed = value != this->last_value && std::fabs(value - this->last_value) >= threshold;
+      }
+      else
+      {
+        // No deadband, only the intervals limit the rate
+        changed = true;
+      }
+      if (!due && !changed)
+      {
+        return false;
+      }
+      this->last_value = value;
+      this->last_time = now;
+      this->published = true;
+      return true;
     }
 
-    // Reset the current channel count to trigger the next data reading cycle
-    void BL0910::update()
+    // Bucket of a duration: exact below 4 us, then the octave and the two bits after the leading one
+    static uint8_t duration_bucket(uint32_t us)
+    {
+      if (us < 4)
+      {
+        return us;
+      }
+      uint8_t octave = 31 - __builtin_clz(us);
+      uint32_t bucket = 4 * (octave - 1) + ((us >> (octave - 2)) & 3);
+      return std::min<uint32_t>(bucket, DurationHistogram::BUCKET_COUNT - 1);
+    }
+
+    // First duration past a bucket
+    static uint32_t bucket_limit(uint8_t bucket)
     {
-      this->current_channel_ = 0;
+      if (bucket < 4)
+      {
+        return bucket + 1;
+      }
+      uint8_t octave = bucket / 4 + 1;
+      return (uint32_t) (4 + bucket % 4 + 1) << (octave - 2);
     }
 
-    std::queue<ActionCallbackFuncPtr> enqueue_action_;
-    // Add action to queue
-    size_t BL0910::enqueue_action_(ActionCallbackFuncPtr function)
+    void DurationHistogram::add(uint32_t us)
     {
-      this->action_queue_.push_back(function);
-      return this->action_queue_.size();
+      this->counts[duration_bucket(us)]++;
+      this->total++;
+      if (us > this->max)
+      {
+        this->max = us;
+      }
     }
 
-    // Process all operations in the action queue
-    void BL0910::handle_actions_()
+    // Bucket bounds overestimate by 19% at most, and never beyond the largest duration seen
+    uint32_t DurationHistogram::percentile(float fraction) const
     {
-      if (this->action_queue_.empty())
+      if (this->total == 0)
       {
-        return;
+        return 0;
       }
-      ActionCallbackFuncPtr ptr_func = nullptr;
-      // Traverse all actions and execute
-      for (int i = 0; i < this->action_queue_.size(); i++)
+      uint32_t rank = (uint32_t) std::ceil(fraction * this->total);
+      uint32_t seen = 0;
+      for (uint8_t bucket = 0; bucket < BUCKET_COUNT; bucket++)
       {
-        ptr_func = this->action_queue_[i];
-        if (ptr_func)
+        seen += this->counts[bucket];
+        if (seen >= rank && seen != 0)
         {
-          ESP_LOGI(TAG, "HandleActionCallback[%d]...", i);
-          (this->*ptr_func)();
+          // The last bucket is open ended
+          return bucket == BUCKET_COUNT - 1 ? this->max : std::min(bucket_limit(bucket) - 1, this->max);
         }
       }
-      // Read the remaining data and clear the queue
-      while (this->available())
+      return this->max;
+    }
+
+    // Apparent power and power factor of a channel from the held voltage, current and power.
+    // In snapshot mode the voltage was read right before the channel's current and power.
+    void BL0910::derive_channel_power_(uint8_t index)
+    {
+      uint8_t fresh = this->channels_.fresh[index];
+      // Only from current read in this sweep
+      if (!(fresh & (1 << (uint8_t) ChannelSlot::CURRENT)) || std::isnan(this->voltage_))
+      {
+        return;
+      }
+      float current = this->channels_.values[(uint8_t) ChannelSlot::CURRENT][index];
+      float apparent_power = this->voltage_ * current;
+      this->channels_.values[(uint8_t) ChannelSlot::APPARENT_POWER][index] = apparent_power;
+      if (this->telemetry_enabled_)
+      {
+        this->telemetry_.add(TelemetryQuantity::APPARENT_POWER, index + 1, 0, apparent_power);
+      }
+      sensor::Sensor *apparent_power_sensor = this->channels_.sensors[(uint8_t) ChannelSlot::APPARENT_POWER][index];
+      if (apparent_power_sensor != nullptr)
       {
-        this->read_byte();
+        this->publish_(apparent_power_sensor, apparent_power, this->channels_.gates[(uint8_t) ChannelSlot::APPARENT_POWER][index]);
       }
 
-      this->action_queue_.clear();
+      sensor::Sensor *power_factor_sensor = this->channels_.sensors[(uint8_t) ChannelSlot::POWER_FACTOR][index];
+      if (power_factor_sensor == nullptr || !(fresh & (1 << (uint8_t) ChannelSlot::POWER)))
+      {
+        return;
+      }
+      float power_factor = NAN;
+      // No load: the ratio is noise over noise, report it as undefined
+      if (apparent_power >= this->min_apparent_power_)
+      {
+        float power = this->channels_.values[(uint8_t) ChannelSlot::POWER][index];
+        // Signed, negative when the channel exports
+        power_factor = std::clamp(power / apparent_power, -1.0f, 1.0f);
+      }
+      this->channels_.values[(uint8_t) ChannelSlot::POWER_FACTOR][index] = power_factor;
+      if (this->telemetry_enabled_)
+      {
+        this->telemetry_.add(TelemetryQuantity::POWER_FACTOR, index + 1, 0, power_factor);
+      }
+      this->publish_(power_factor_sensor, power_factor, this->channels_.gates[(uint8_t) ChannelSlot::POWER_FACTOR][index]);
+    }
 
-      // Clear buffer after handling action
-      this->flush();
+    // Write a 24-bit value to a register as one frame
+    template <typename Transport>
+    void BL0910Core<Transport>::write_register_(uint8_t address, int32_t value)
+    {
+      DataPacket data;
+      data.l = (value >> 0) & 0xFF;
+      data.m = (value >> 8) & 0xFF;
+      data.h = (value >> 16) & 0xFF;
+      data.checksum = bl0910_checksum(address, &data);
+      if constexpr (Transport::SPI_FRAMING) {
+        // SPI write: 0x81, Addr, H, M, L, checksum
+        uint8_t *frame = this->spi_frames_;
+        frame[0] = BL0910_SPI_WRITE_COMMAND;
+        frame[1] = address;
+        frame[2] = data.h;
+        frame[3] = data.m;
+        frame[4] = data.l;
+        frame[5] = data.checksum;
+        this->transport_()->bus_transfer_(frame, 1);
+      } else {
+        // UART write: 0xCA, Addr, L, M, H, checksum
+        const uint8_t frame[BL0910_FRAME_SIZE] = {BL0910_WRITE_COMMAND, address, data.l, data.m, data.h, data.checksum};
+        this->transport_()->bus_write_(frame, BL0910_FRAME_SIZE);
+      }
+      this->diagnostics_.sent(1, BL0910_FRAME_SIZE);
+      this->record_frame_(TraceKind::WRITE, address, data);
     }
 
-    // Reset energy
-    void BL0910::reset_energy_()
+    // Calibration register of a kind for channel 1, the other channels follow it
+    static const uint8_t CALIBRATION_REGISTERS[CALIBRATION_KIND_COUNT] = {BL0910_RMSOS_1, BL0910_RMSGN_1, BL0910_WATTGN_1};
+    // Significant bits of each kind, compared on readback
+    static const uint8_t CALIBRATION_WIDTHS[CALIBRATION_KIND_COUNT] = {24, 16, 16};
+    static const uint8_t CALIBRATION_REGISTER_COUNT = CALIBRATION_KIND_COUNT * BL0910_CHANNEL_COUNT;
+
+    // Address of a calibration register by its shadow bit, kind * 10 + channel - 1
+    static uint8_t calibration_address(uint8_t bit)
     {
-      if (this->comm_mode_ == CommunicationMode::SPI) {
-        // SPI interface reset: send six 0xFF
-        this->flush();
-        for (int i = 0; i < 6; i++) {
-          this->write_byte(0xFF);
+      return CALIBRATION_REGISTERS[bit / BL0910_CHANNEL_COUNT] + bit % BL0910_CHANNEL_COUNT;
+    }
+    // Shadow bit of a calibration register address, CALIBRATION_REGISTER_COUNT if it is none
+    static uint8_t calibration_bit(uint8_t address)
+    {
+      for (uint8_t kind = 0; kind < CALIBRATION_KIND_COUNT; kind++)
+      {
+        if (address >= CALIBRATION_REGISTERS[kind] && address < CALIBRATION_REGISTERS[kind] + BL0910_CHANNEL_COUNT)
+        {
+          return kind * BL0910_CHANNEL_COUNT + address - CALIBRATION_REGISTERS[kind];
         }
-        ESP_LOGW(TAG, "SPI interface reset with 6×0xFF");
-      } else {
-        // UART initialization sequence
-        this->write_array(BL0910_INIT[0], 6);
-        delay(1);
-        this->flush();
-        ESP_LOGW(TAG, "Device reset with init command.");
       }
+      return CALIBRATION_REGISTER_COUNT;
+    }
+    // Whether a value read back from a calibration register matches its shadow
+    static bool calibration_matches(uint8_t bit, uint32_t raw, int32_t value)
+    {
+      uint32_t mask = (1UL << CALIBRATION_WIDTHS[bit / BL0910_CHANNEL_COUNT]) - 1;
+      return (raw & mask) == ((uint32_t) value & mask);
     }
 
-    // Read data
-    void BL0910::read_data_(const uint8_t address, const float reference, sensor::Sensor *sensor)
+    // Write USR_WRPROT unless the chip already holds the value
+    template <typename Transport>
+    void BL0910Core<Transport>::set_write_protection_(uint32_t value)
     {
-      if (sensor == nullptr)
+      if (this->write_protection_ == (int32_t) value)
       {
         return;
       }
+      this->write_register_(BL0910_USR_WRPROT, value);
+      this->write_protection_ = value;
+    }
 
-      // SPI-specific read path: use SPI commands and MSB-first ordering
-      if (this->comm_mode_ == CommunicationMode::SPI) {
-        DataPacket buffer;
-        ube24_t data_u24;
-        sbe24_t data_s24;
-        // Initiate SPI read frame
-        this->flush();
-        this->write_byte(BL0910_SPI_READ_COMMAND);
-        this->write_byte(address);
-        // Read 3 data bytes + checksum
-        if (!this->read_array((uint8_t *)&buffer, sizeof(buffer) - 1))
-          return;
-        if (bl0910_checksum(address, &buffer) != buffer.checksum) {
-          ESP_LOGW(TAG, "SPI checksum failed. Discarding message.");
-          return;
-        }
-        // Determine signed vs unsigned
-        bool signed_result_spi = reference == BL0910_TREF || reference == BL0910_WATT || reference == BL0910_PREF;
-        // SPI shifts MSB first: buffer.l=H, buffer.m=M, buffer.h=L
-        if (signed_result_spi) {
-          data_s24.l = buffer.h;
-          data_s24.m = buffer.m;
-          data_s24.h = buffer.l;
-        } else {
-          data_u24.l = buffer.h;
-          data_u24.m = buffer.m;
-          data_u24.h = buffer.l;
-        }
-        // Convert to float using same reference logic
-        float value = 0;
-        if (reference == BL0910_PREF || reference == BL0910_WATT) {
-          value = (float)to_int32_t(data_s24) * reference;
-        } else if (reference == BL0910_UREF || reference == BL0910_IREF || reference == BL0910_EREF || reference == BL0910_CF) {
-          value = (float)to_uint32_t(data_u24) * reference;
-        } else if (reference == BL0910_FREF) {
-          value = reference / (float)to_uint32_t(data_u24);
-        } else if (reference == BL0910_TREF) {
-          int32_t raw = to_int32_t(data_s24);
-          value = (raw - 64) * 12.5 / 59 - 40;
-        }
-        sensor->publish_state(value);
+    // Write the dirty calibration registers as one batch: unlock, write, relock. Each is then read
+    // back by verify_calibration_(), one per idle loop(), so no reply is waited for here.
+    template <typename Transport>
+    void BL0910Core<Transport>::apply_calibration_()
+    {
+      uint32_t dirty = this->calibration_dirty_;
+      if (dirty == 0)
+      {
         return;
       }
+      this->discard_input_();
+      this->set_write_protection_(BL0910_USR_WRPROT_WRITABLE);
+      for (uint8_t bit = 0; bit < CALIBRATION_REGISTER_COUNT; bit++)
+      {
+        if (dirty & (1UL << bit))
+        {
+          this->write_register_(calibration_address(bit), this->calibration_.values[bit / BL0910_CHANNEL_COUNT][bit % BL0910_CHANNEL_COUNT]);
+        }
+      }
+      this->set_write_protection_(BL0910_USR_WRPROT_READ_ONLY);
+      this->calibration_dirty_ = 0;
+      this->calibration_unverified_ |= dirty;
+    }
 
-      DataPacket buffer;
-      ube24_t data_u24;
-      sbe24_t data_s24;
-      float value = 0;
-
-      // Determine if the data type is signed
-      bool signed_result = reference == BL0910_TREF || reference == BL0910_WATT || reference == BL0910_PREF;
-      this->flush();
-      this->write_byte(BL0910_READ_COMMAND);
-      this->write_byte(address);
+    // Read back one register of the last calibration batch. One that does not match stays dirty
+    // until the next batch. Saved to flash once the whole batch verified.
+    template <typename Transport>
+    void BL0910Core<Transport>::verify_calibration_()
+    {
+      uint8_t bit = __builtin_ctz(this->calibration_unverified_);
+      this->discard_input_();
+      uint32_t raw;
+      if (!this->read_register_(calibration_address(bit), raw))
+      {
+        // A bus error says nothing about the register, read it again next loop()
+        return;
+      }
+      this->calibration_unverified_ &= ~(1UL << bit);
+      if (!calibration_matches(bit, raw, this->calibration_.values[bit / BL0910_CHANNEL_COUNT][bit % BL0910_CHANNEL_COUNT]))
+      {
+        ESP_LOGE(TAG, "Calibration register 0x%02X did not verify", calibration_address(bit));
+        this->calibration_dirty_ |= 1UL << bit;
+      }
+      // Between batches only registers that did not verify are dirty
+      if (this->calibration_unverified_ != 0 || this->calibration_dirty_ != 0)
+      {
+        return;
+      }
+      ESP_LOGI(TAG, "Calibration: registers written and verified");
+      if (this->calibration_key_ != 0)
+      {
+        this->calibration_pref_.save(&this->calibration_);
+      }
+    }
 
-      // Read data
-      if (this->read_array((uint8_t *)&buffer, sizeof(buffer) - 1))
+    // Run every queued command in one go. Register writes share one unlocked window with the
+    // calibration batch, and calibrations queued together are written and verified together.
+    template <typename Transport>
+    void BL0910Core<Transport>::handle_commands_()
+    {
+      bool calibrated = false;
+      Command command;
+      while (this->commands_.pop(command))
       {
-        if (bl0910_checksum(address, &buffer) == buffer.checksum)
+        switch (command.type)
         {
-          // Handle different data formats based on whether they are signed
-          if (signed_result)
+        case CommandType::RESET_ENERGY:
+          this->reset_energy_();
+          break;
+        case CommandType::WRITE_REGISTER:
+        {
+          uint8_t bit = calibration_bit(command.target);
+          if (bit != CALIBRATION_REGISTER_COUNT)
+          {
+            // Through the shadow, so that verification keeps the value rather than restoring the old one
+            int32_t &value = this->calibration_.values[bit / BL0910_CHANNEL_COUNT][bit % BL0910_CHANNEL_COUNT];
+            if (value != command.value || (this->calibration_dirty_ & (1UL << bit)))
+            {
+              value = command.value;
+              this->calibration_dirty_ |= 1UL << bit;
+              calibrated = true;
+            }
+          }
+          else if (command.target == BL0910_USR_WRPROT)
           {
-            data_s24.l = buffer.l;
-            data_s24.m = buffer.m;
-            data_s24.h = buffer.h;
+            this->set_write_protection_(command.value);
           }
           else
           {
-            data_u24.l = buffer.l;
-            data_u24.m = buffer.m;
-            data_u24.h = buffer.h;
+            this->set_write_protection_(BL0910_USR_WRPROT_WRITABLE);
+            this->write_register_(command.target, command.value);
           }
+          break;
         }
-        else
-        {
-          ESP_LOGW(TAG, "Checksum failed. Discarding message."); // If checksum error, discard data
-          return;
+        case CommandType::CALIBRATE:
+          calibrated |= this->calibrate_(command.target, command.kind, command.reference);
+          break;
+        case CommandType::CAPTURE_WAVEFORM:
+          if (this->waveform_channel_ != 0)
+          {
+            this->start_capture_();
+          }
+          break;
+        case CommandType::DUMP_TRACE:
+          this->dump_trace_();
+          break;
         }
       }
-      // Process data according to different reference values
-      if (reference == BL0910_PREF || reference == BL0910_WATT)
+      uint32_t dropped = this->commands_.take_dropped();
+      if (dropped != 0)
       {
-        value = (float)to_int32_t(data_s24) * reference;
+        ESP_LOGW(TAG, "Command queue full, %u commands dropped", dropped);
       }
-      if (reference == BL0910_UREF || reference == BL0910_IREF || reference == BL0910_EREF || reference == BL0910_CF)
+      if (calibrated)
       {
-        value = (float)to_uint32_t(data_u24) * reference;
+        this->apply_calibration_();
       }
-      if (reference == BL0910_FREF)
+      if (this->write_protection_ == (int32_t) BL0910_USR_WRPROT_WRITABLE)
       {
-        value = reference / (float)to_uint32_t(data_u24);
+        this->set_write_protection_(BL0910_USR_WRPROT_READ_ONLY);
       }
-      if (reference == BL0910_TREF)
-      {
-        value = (float)to_int32_t(data_s24);
-        value = (value - 64) * 12.5 / 59 - 40;
-      }
-      sensor->publish_state(value);
+      // Drop whatever the commands left in the receive buffer
+      this->discard_input_();
     }
 
-    // Calculate power factor
-    void BL0910::calculate_power_factor_(sensor::Sensor *current_sensor, sensor::Sensor *voltage_sensor, sensor::Sensor *power_sensor, sensor::Sensor *power_factor_sensor)
+    // Read back one calibrated register, rotating through them. A mismatch means the chip lost its
+    // registers (brown-out or reset), so the whole shadow is written back.
+    template <typename Transport>
+    void BL0910Core<Transport>::verify_shadow_()
     {
-      if (current_sensor != nullptr && voltage_sensor != nullptr && power_sensor != nullptr && power_factor_sensor != nullptr)
+      this->last_verify_ = millis();
+      uint32_t calibrated = this->calibrated_registers_() & ~(this->calibration_dirty_ | this->calibration_unverified_);
+      if (calibrated == 0)
       {
-        float power_factor = (current_sensor->state * voltage_sensor->state) / power_sensor->state;
-        power_factor_sensor->publish_state(power_factor);
+        return;
       }
-    }
-
-    // Bias calibration function
-    void BL0910::bias_correction_(uint8_t address, float measurements, float correction)
-    {
-      DataPacket data;
-      float i_rms0 = measurements * BL0910_KI;
-      float i_rms = correction * BL0910_KI;
-      int32_t value = (i_rms * i_rms - i_rms0 * i_rms0) / 256; // Calculate calibration value
-      // Write calculated value to data packet
-      data.l = (value >> 0) & 0xFF;
-      data.m = (value >> 8) & 0xFF;
-      data.h = (value >> 16) & 0xFF;
-      data.checksum = bl0910_checksum(address, &data);
-      if (this->comm_mode_ == CommunicationMode::SPI) {
-        // SPI write: 0x81, Addr, H, M, L, checksum
-        this->flush();
-        this->write_byte(BL0910_SPI_WRITE_COMMAND);
-        this->write_byte(address);
-        this->write_byte(data.h);
-        this->write_byte(data.m);
-        this->write_byte(data.l);
-        this->write_byte(data.checksum);
-      } else {
-        // UART write: 0xCA, Addr, L, M, H, checksum
-        this->flush();
-        this->write_byte(BL0910_WRITE_COMMAND);
-        this->write_byte(address);
-        this->write_byte(data.l);
-        this->write_byte(data.m);
-        this->write_byte(data.h);
-        this->write_byte(data.checksum);
+      uint8_t bit = this->verify_index_;
+      while (!(calibrated & (1UL << bit)))
+      {
+        bit = (bit + 1) % CALIBRATION_REGISTER_COUNT;
+      }
+      this->verify_index_ = (bit + 1) % CALIBRATION_REGISTER_COUNT;
+      this->discard_input_();
+      uint32_t raw;
+      if (!this->read_register_(calibration_address(bit), raw))
+      {
+        // A bus error says nothing about the chip, check again next interval
+        return;
+      }
+      if (calibration_matches(bit, raw, this->calibration_.values[bit / BL0910_CHANNEL_COUNT][bit % BL0910_CHANNEL_COUNT]))
+      {
+        return;
       }
+      ESP_LOGW(TAG, "Register 0x%02X lost its calibration, restoring after a chip reset", calibration_address(bit));
+      this->calibration_dirty_ |= this->calibrated_registers_();
+      // The reset also restored the chip's write protection
+      this->write_protection_ = -1;
+      this->apply_calibration_();
     }
 
-    // Gain calibration function
-    void BL0910::gain_correction_(uint8_t address, float measurements, float correction)
+    template <typename Transport>
+    void BL0910Core<Transport>::dump_config()
     {
-      DataPacket data;
-      float i_rms0 = measurements * BL0910_KI;
-      float i_rms = correction * BL0910_KI;
-      int32_t value = int((i_rms / i_rms0 - 1) * 65536); // Calculate calibration value
-      // Write calculated value to data packet
-      data.l = (value >> 0) & 0xFF;
-      data.m = (value >> 8) & 0xFF;
-      data.h = (value >> 16) & 0xFF;
-      data.checksum = bl0910_checksum(address, &data);
-      if (this->comm_mode_ == CommunicationMode::SPI) {
-        // SPI write: 0x81, Addr, H, M, L, checksum
-        this->flush();
-        this->write_byte(BL0910_SPI_WRITE_COMMAND);
-        this->write_byte(address);
-        this->write_byte(data.h);
-        this->write_byte(data.m);
-        this->write_byte(data.l);
-        this->write_byte(data.checksum);
-      } else {
-        // UART write: 0xCA, Addr, L, M, H, checksum
-        this->flush();
-        this->write_byte(BL0910_WRITE_COMMAND);
-        this->write_byte(address);
-        this->write_byte(data.l);
-        this->write_byte(data.m);
-        this->write_byte(data.h);
-        this->write_byte(data.checksum);
+      ESP_LOGCONFIG(TAG, "BL0910:");
+      if constexpr (Transport::SPI_FRAMING)
+      {
+        ESP_LOGCONFIG(TAG, "  Communication Mode: SPI");
+        ESP_LOGCONFIG(TAG, "  Data Rate: %u kHz", this->bus_rate_ / 1000);
+        if (this->tuning_.enabled)
+        {
+          ESP_LOGCONFIG(TAG, "  Data Rate Tuning: %u-%u kHz, max %.2f%% checksum errors", this->tuning_.min_rate / 1000,
+                        this->tuning_.max_rate / 1000, this->tuning_.max_error_rate * 100.0f);
+        }
+        ESP_LOGCONFIG(TAG, "  Burst Reads: %s", YESNO(this->spi_burst_));
+      }
+      else
+      {
+        ESP_LOGCONFIG(TAG, "  Communication Mode: UART");
+        ESP_LOGCONFIG(TAG, "  Pipeline Depth: %u", this->pipeline_depth_);
+      }
+      ESP_LOGCONFIG(TAG, "  Reads per Sweep: %u", this->schedule_size_);
+      ESP_LOGCONFIG(TAG, "  Snapshot Sampling: %s", YESNO(this->snapshot_sampling_));
+      ESP_LOGCONFIG(TAG, "  Statistics Window: %.1f s", this->statistics_window_ / 1000.0f);
+      if (this->watch_size_ > 0)
+      {
+        ESP_LOGCONFIG(TAG, "  Overload Watch: %u reads every %.1f ms", this->watch_size_, this->watch_interval_us_ / 1000.0f);
+      }
+      if (this->adaptive_)
+      {
+        ESP_LOGCONFIG(TAG, "  Adaptive Polling: max staleness %.1f s, change %.1f%%, max %u reads per update",
+                      this->max_staleness_ / 1000.0f, this->change_ratio_ * 100.0f, this->max_reads_per_sweep_);
+        // Without enough budget for every group within the staleness limit, steady channels starve
+        uint32_t updates = this->max_staleness_ / std::max<uint32_t>(this->get_update_interval(), 1);
+        if (this->max_reads_per_sweep_ != 0 && (uint32_t) this->max_reads_per_sweep_ * updates < this->schedule_size_)
+        {
+          ESP_LOGW(TAG, "  %u reads per update cannot read all %u within max staleness", this->max_reads_per_sweep_,
+                   this->schedule_size_);
+        }
+      }
+      if (this->waveform_channel_ != 0)
+      {
+        char source[12] = "voltage";
+        if (this->waveform_channel_ != WAVEFORM_VOLTAGE)
+        {
+          snprintf(source, sizeof(source), "channel %u", this->waveform_channel_);
+        }
+        ESP_LOGCONFIG(TAG, "  Waveform Capture: %s, %u x %u samples every %u s, harmonics up to %u", source,
+                      this->waveform_segments_, this->waveform_samples_, this->waveform_interval_ / 1000,
+                      this->max_harmonic_);
+      }
+      uint32_t calibrated = this->calibrated_registers_();
+      if (calibrated != 0)
+      {
+        ESP_LOGCONFIG(TAG, "  Calibration: %u registers set, one read back every %u s", __builtin_popcount(calibrated),
+                      this->verify_interval_ / 1000);
+      }
+      if ((this->calibration_dirty_ | this->calibration_unverified_) != 0)
+      {
+        ESP_LOGW(TAG, "  Calibration: %u registers not verified",
+                 __builtin_popcount(this->calibration_dirty_ | this->calibration_unverified_));
+      }
+      const BusDiagnostics &diagnostics = this->diagnostics_;
+      ESP_LOGCONFIG(TAG, "  Read Retries: %u per update", this->recovery_.budget);
+      if (this->telemetry_enabled_)
+      {
+        ESP_LOGCONFIG(TAG, "  Telemetry: chip %u, %u frames sent", this->telemetry_chip_, this->telemetry_sequence_);
       }
+      if (this->trace_capacity_ != 0)
+      {
+        ESP_LOGCONFIG(TAG, "  Trace: last %u frames recorded", this->trace_capacity_);
+      }
+      ESP_LOGCONFIG(TAG,
+                    "  Bus: %llu frames, %llu bytes, %u checksum errors, %u timeouts, %u retries, %u reads discarded, "
+                    "%u watch reads failed",
+                    (unsigned long long) diagnostics.frames, (unsigned long long) diagnostics.bytes,
+                    diagnostics.checksum_errors, diagnostics.timeouts, diagnostics.retries, diagnostics.discarded_reads,
+                    diagnostics.watch_failures);
+      ESP_LOGCONFIG(TAG, "  loop(): p50 %u us, p99 %u us, max %u us; sweep last %u us, max %u us; published every %u s",
+                    diagnostics.loop_time.percentile(0.5f), diagnostics.loop_time.percentile(0.99f),
+                    diagnostics.loop_max_us, diagnostics.last_sweep_us, diagnostics.max_sweep_us,
+                    this->diagnostics_interval_ / 1000);
+      ESP_LOGCONFIG(TAG, "  Restore Energy: %s", YESNO(this->restore_energy_));
+      if (this->restore_energy_)
+      {
+        ESP_LOGCONFIG(TAG, "  Energy Saved Every: %.1f Wh or %u s", this->energy_save_threshold_ * 1000.0f,
+                      this->energy_save_interval_ / 1000);
+      }
+      this->dump_sensors_();
     }
 
-    void BL0910::dump_config()
+    static const char *const STAT_SLOT_NAMES[STAT_SLOT_COUNT] = {"Current", "Power"};
+    static const char *const STAT_KIND_NAMES[STAT_KIND_COUNT] = {"min", "max", "mean", "stddev", "RMS"};
+
+    void BL0910::dump_sensors_()
     {
-      ESP_LOGCONFIG(TAG, "BL0910:");
-      ESP_LOGCONFIG(TAG, "  Communication Mode: %s", this->get_comm_mode() == CommunicationMode::UART ? "UART" : "SPI");
-      
       LOG_SENSOR("  ", "Voltage", this->voltage_sensor_);
 
-      LOG_SENSOR("  ", "Current1", this->current_1_sensor_);
-      LOG_SENSOR("  ", "Current2", this->current_2_sensor_);
-      LOG_SENSOR("  ", "Current3", this->current_3_sensor_);
-      LOG_SENSOR("  ", "Current4", this->current_4_sensor_);
-      LOG_SENSOR("  ", "Current5", this->current_5_sensor_);
-      LOG_SENSOR("  ", "Current6", this->current_6_sensor_);
-      LOG_SENSOR("  ", "Current7", this->current_7_sensor_);
-      LOG_SENSOR("  ", "Current8", this->current_8_sensor_);
-      LOG_SENSOR("  ", "Current9", this->current_9_sensor_);
-      LOG_SENSOR("  ", "Current10", this->current_10_sensor_);
-
-      LOG_SENSOR("  ", "Power1", this->power_1_sensor_);
-      LOG_SENSOR("  ", "Power2", this->power_2_sensor_);
-      LOG_SENSOR("  ", "Power3", this->power_3_sensor_);
-      LOG_SENSOR("  ", "Power4", this->power_4_sensor_);
-      LOG_SENSOR("  ", "Power5", this->power_5_sensor_);
-      LOG_SENSOR("  ", "Power6", this->power_6_sensor_);
-      LOG_SENSOR("  ", "Power7", this->power_7_sensor_);
-      LOG_SENSOR("  ", "Power8", this->power_8_sensor_);
-      LOG_SENSOR("  ", "Power9", this->power_9_sensor_);
-      LOG_SENSOR("  ", "Power10", this->power_10_sensor_);
-
-      LOG_SENSOR("  ", "Power factor 1", this->power_factor_1_sensor_);
-      LOG_SENSOR("  ", "Power factor 2", this->power_factor_2_sensor_);
-      LOG_SENSOR("  ", "Power factor 3", this->power_factor_3_sensor_);
-      LOG_SENSOR("  ", "Power factor 4", this->power_factor_4_sensor_);
-      LOG_SENSOR("  ", "Power factor 5", this->power_factor_5_sensor_);
-      LOG_SENSOR("  ", "Power factor 6", this->power_factor_6_sensor_);
-      LOG_SENSOR("  ", "Power factor 7", this->power_factor_7_sensor_);
-      LOG_SENSOR("  ", "Power factor 8", this->power_factor_8_sensor_);
-      LOG_SENSOR("  ", "Power factor 9", this->power_factor_9_sensor_);
-      LOG_SENSOR("  ", "Power factor 10", this->power_factor_10_sensor_);
-
-      LOG_SENSOR("  ", "Energy1", this->energy_1_sensor_);
-      LOG_SENSOR("  ", "Energy2", this->energy_2_sensor_);
-      LOG_SENSOR("  ", "Energy3", this->energy_3_sensor_);
-      LOG_SENSOR("  ", "Energy4", this->energy_4_sensor_);
-      LOG_SENSOR("  ", "Energy5", this->energy_5_sensor_);
-      LOG_SENSOR("  ", "Energy6", this->energy_6_sensor_);
-      LOG_SENSOR("  ", "Energy7", this->energy_7_sensor_);
-      LOG_SENSOR("  ", "Energy8", this->energy_8_sensor_);
-      LOG_SENSOR("  ", "Energy9", this->energy_9_sensor_);
-      LOG_SENSOR("  ", "Energy10", this->energy_10_sensor_);
+      for (uint8_t i = 0; i < BL0910_CHANNEL_COUNT; i++)
+      {
+        bool configured = false;
+        for (uint8_t slot = 0; slot < CHANNEL_SLOT_COUNT; slot++)
+        {
+          configured |= this->channels_.sensors[slot][i] != nullptr;
+        }
+        for (uint8_t slot = 0; slot < WATCH_SLOT_COUNT; slot++)
+        {
+          configured |= !std::isnan(this->limits_[slot][i].threshold);
+        }
+        if (!configured && this->statistics_.slots[i] == 0)
+        {
+          continue;
+        }
+        ESP_LOGCONFIG(TAG, "  Channel %u:", i + 1);
+        LOG_SENSOR("    ", "Current", this->channels_.sensors[(uint8_t) ChannelSlot::CURRENT][i]);
+        LOG_SENSOR("    ", "Power", this->channels_.sensors[(uint8_t) ChannelSlot::POWER][i]);
+        LOG_SENSOR("    ", "Energy", this->channels_.sensors[(uint8_t) ChannelSlot::ENERGY][i]);
+        LOG_SENSOR("    ", "Power factor", this->channels_.sensors[(uint8_t) ChannelSlot::POWER_FACTOR][i]);
+        LOG_SENSOR("    ", "Apparent power", this->channels_.sensors[(uint8_t) ChannelSlot::APPARENT_POWER][i]);
+        for (uint8_t slot = 0; slot < STAT_SLOT_COUNT; slot++)
+        {
+          for (uint8_t kind = 0; kind < STAT_KIND_COUNT; kind++)
+          {
+            sensor::Sensor *sensor = this->statistics_.sensors[slot][kind][i];
+            if (sensor != nullptr)
+            {
+              ESP_LOGCONFIG(TAG, "    %s %s '%s'", STAT_SLOT_NAMES[slot], STAT_KIND_NAMES[kind], sensor->get_name().c_str());
+            }
+          }
+        }
+        const WatchLimit &overcurrent = this->limits_[(uint8_t) ChannelSlot::CURRENT][i];
+        if (!std::isnan(overcurrent.threshold))
+        {
+          ESP_LOGCONFIG(TAG, "    Overcurrent: above %.3f A, re-armed below %.3f A", overcurrent.threshold, overcurrent.release);
+        }
+        const WatchLimit &overpower = this->limits_[(uint8_t) ChannelSlot::POWER][i];
+        if (!std::isnan(overpower.threshold))
+        {
+          ESP_LOGCONFIG(TAG, "    Overpower: above %.1f W, re-armed below %.1f W", overpower.threshold, overpower.release);
+        }
+      }
 
       LOG_SENSOR("  ", "Total Power", this->total_power_sensor_);
       LOG_SENSOR("  ", "Total Energy", this->total_energy_sensor_);
       LOG_SENSOR("  ", "Frequency", this->frequency_sensor_);
       LOG_SENSOR("  ", "Temperature", this->temperature_sensor_);
+      LOG_SENSOR("  ", "THD", this->thd_sensor_);
+      for (uint8_t order = 2; order <= WAVEFORM_MAX_HARMONIC; order++)
+      {
+        if (this->harmonic_sensors_[order] != nullptr)
+        {
+          ESP_LOGCONFIG(TAG, "  Harmonic %u '%s'", order, this->harmonic_sensors_[order]->get_name().c_str());
+        }
+      }
+      LOG_SENSOR("  ", "Frames Sent", this->diagnostic_sensors_[(uint8_t) DiagnosticSlot::FRAMES]);
+      LOG_SENSOR("  ", "Bytes on Wire", this->diagnostic_sensors_[(uint8_t) DiagnosticSlot::BYTES]);
+      LOG_SENSOR("  ", "Checksum Errors", this->diagnostic_sensors_[(uint8_t) DiagnosticSlot::CHECKSUM_ERRORS]);
+      LOG_SENSOR("  ", "Timeouts", this->diagnostic_sensors_[(uint8_t) DiagnosticSlot::TIMEOUTS]);
+      LOG_SENSOR("  ", "Retries", this->diagnostic_sensors_[(uint8_t) DiagnosticSlot::RETRIES]);
+      LOG_SENSOR("  ", "Discarded Reads", this->diagnostic_sensors_[(uint8_t) DiagnosticSlot::DISCARDED_READS]);
+      LOG_SENSOR("  ", "Loop Time p50", this->diagnostic_sensors_[(uint8_t) DiagnosticSlot::LOOP_TIME_P50]);
+      LOG_SENSOR("  ", "Loop Time p99", this->diagnostic_sensors_[(uint8_t) DiagnosticSlot::LOOP_TIME_P99]);
+      LOG_SENSOR("  ", "Loop Time Max", this->diagnostic_sensors_[(uint8_t) DiagnosticSlot::LOOP_TIME_MAX]);
+      LOG_SENSOR("  ", "Sweep Duration", this->diagnostic_sensors_[(uint8_t) DiagnosticSlot::SWEEP_DURATION]);
+      LOG_SENSOR("  ", "Data Rate", this->diagnostic_sensors_[(uint8_t) DiagnosticSlot::DATA_RATE]);
     }
 
     // SPI Implementation
-    void BL0910SPI::write_byte(uint8_t data) {
-      this->transfer_byte(data); // SPIDevice::transfer_byte handles CS
+    void BL0910SPI::setup()
+    {
+      this->spi_setup();
+      this->bus_rate_ = this->bus_data_rate_();
+      BL0910::setup();
     }
 
-    uint8_t BL0910SPI::read_byte() {
-      return this->transfer_byte(0x00); // SPIDevice::transfer_byte handles CS, send dummy byte for read
+    // Emulator Implementation
+    // Matches the UART component's read timeout
+    static const uint32_t EMULATOR_READ_TIMEOUT_US = 100000;
+
+    template <bool SPI>
+    void BL0910Emulated<SPI>::setup()
+    {
+      this->emulator_.set_spi_framing(SPI);
+      this->emulator_.set_clock(&micros);
+      if (SPI)
+      {
+        this->bus_rate_ = this->bus_data_rate_();
+      }
+      BL0910::setup();
     }
 
-    bool BL0910SPI::read_array(uint8_t *data, size_t len) {
-      // Fill data with dummy bytes (0x00) to send for reading
-      // SPIDevice::transfer_array will overwrite data with received bytes and handles CS
-      memset(data, 0x00, len);
-      this->transfer_array(data, len);
-      return true;
+    template <bool SPI>
+    void BL0910Emulated<SPI>::update()
+    {
+      // Report the sweep that just finished before starting the next one
+      this->log_stats_();
+      BL0910::update();
     }
 
-    void BL0910SPI::write_array(const uint8_t *data, size_t len) {
-      // Send each byte via SPI transfer
-      for (size_t i = 0; i < len; i++) {
-        this->transfer_byte(data[i]);
-      }
+    template <bool SPI>
+    void BL0910Emulated<SPI>::log_stats_()
+    {
+      const EmulatorStats &stats = this->emulator_.get_stats();
+      const BusDiagnostics &diagnostics = this->diagnostics_;
+      uint32_t loop_avg = diagnostics.loop_count == 0 ? 0 : diagnostics.loop_total_us / diagnostics.loop_count;
+      // SPI is full duplex, every clocked byte goes both ways
+      uint32_t wire_bytes = SPI ? stats.bytes_in : stats.bytes_in + stats.bytes_out;
+      ESP_LOGD(TAG, "Emulator: %u read / %u write frames, %u bytes on wire, %u publishes (%u held back), loop() avg %u us max %u us",
+               stats.read_frames, stats.write_frames, wire_bytes, this->publish_count_, this->suppressed_count_, loop_avg,
+               diagnostics.loop_max_us);
     }
 
-    void BL0910SPI::flush() 
+    template <bool SPI>
+    void BL0910Emulated<SPI>::dump_config()
     {
-      // No buffer to flush in SPI mode
+      BL0910Core<BL0910Emulated<SPI>>::dump_config();
+      const EmulatorConfig &config = this->emulator_.get_config();
+      ESP_LOGCONFIG(TAG, "  Emulator: seed %u, noise %u LSB, reply latency %u us, byte time %u us, corruption %u ppm",
+                    config.seed, config.noise_lsb, config.reply_latency_us, config.byte_time_us, config.corruption_ppm);
+      if (this->emulator_.is_replaying())
+      {
+        ESP_LOGCONFIG(TAG, "  Emulator: replaying %u recorded frames", (unsigned) this->emulator_.replay_size());
+      }
+      this->log_stats_();
     }
 
-    bool BL0910SPI::available() 
+    template <bool SPI>
+    bool BL0910Emulated<SPI>::bus_read_(uint8_t *data, size_t len)
     {
-      // SPI is always available for transaction
+      // Block like the UART component does until the bytes arrive or the timeout passes
+      uint32_t start = micros();
+      while (this->emulator_.available() < len)
+      {
+        if (micros() - start > EMULATOR_READ_TIMEOUT_US)
+          return false;
+      }
+      this->emulator_.transmit(data, len);
       return true;
     }
 
+    template class BL0910Core<BL0910UART>;
+    template class BL0910Core<BL0910SPI>;
+    template class BL0910Core<BL0910EmulatedUART>;
+    template class BL0910Core<BL0910EmulatedSPI>;
+    template class BL0910Emulated<false>;
+    template class BL0910Emulated<true>;
+
   } // namespace bl0910
 } // namespace esphome
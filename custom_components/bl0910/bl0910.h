@@ -6,6 +6,14 @@
 #include "esphome/core/automation.h"
 #include "esphome/core/component.h"
 #include "esphome/core/datatypes.h"
+#include "esphome/core/preferences.h"
+#include <cmath>
+#include "constants.h"
+#include "emulator.h"
+#include "waveform.h"
+#include "command_ring.h"
+#include "telemetry.h"
+#include "trace.h"
 
 namespace esphome
 {
@@ -35,141 +43,904 @@ namespace esphome
       int8_t h{0};
     } __attribute__((packed));
 
-    enum class CommunicationMode {
-      UART,
-      SPI
+    // Sensors of a measurement channel, the register backed slots in SensorSlot order
+    enum class ChannelSlot : uint8_t
+    {
+      CURRENT,
+      POWER,
+      ENERGY,
+      POWER_FACTOR,
+      APPARENT_POWER,
+    };
+    static const uint8_t CHANNEL_SLOT_COUNT = 5;
+    static_assert((uint8_t) ChannelSlot::CURRENT == (uint8_t) SensorSlot::CURRENT &&
+                      (uint8_t) ChannelSlot::POWER == (uint8_t) SensorSlot::POWER &&
+                      (uint8_t) ChannelSlot::ENERGY == (uint8_t) SensorSlot::ENERGY,
+                  "channel slots must match their register slots");
+
+    static const uint8_t SENSOR_SLOT_COUNT = (uint8_t) SensorSlot::TOTAL_ENERGY + 1;
+
+    // When a sensor publishes, judged on the converted reading before any sensor filters
+    struct PublishPolicy
+    {
+      // Publish only once the value moved at least this far from the last published one, in
+      // sensor units or as a fraction of the last published value (the larger wins)
+      float deadband{0};
+      float deadband_ratio{0};
+      // At most one publish per min_interval_ms, at least one per max_interval_ms (0 = no limit)
+      uint32_t min_interval_ms{0};
+      uint32_t max_interval_ms{0};
+    };
+
+    // Publish policy of one sensor and what it last published
+    struct PublishGate
+    {
+      PublishPolicy policy;
+      float last_value{NAN};
+      uint32_t last_time{0};
+      bool published{false};
+
+      bool admit(float value, uint32_t now);
+    };
+
+    // Sensors and readings of all channels, one array per field indexed by [slot][channel - 1]
+    struct ChannelArrays
+    {
+      sensor::Sensor *sensors[CHANNEL_SLOT_COUNT][BL0910_CHANNEL_COUNT]{};
+      // Only for sensors with a publish policy
+      PublishGate *gates[CHANNEL_SLOT_COUNT][BL0910_CHANNEL_COUNT]{};
+      // Last value per slot, as converted from the chip before any sensor filters
+      float values[CHANNEL_SLOT_COUNT][BL0910_CHANNEL_COUNT]{};
+      // Slots read in the current sweep, bit n for ChannelSlot n
+      uint8_t fresh[BL0910_CHANNEL_COUNT]{};
+    };
+
+    // Summaries of a channel quantity over a statistics window
+    enum class StatKind : uint8_t
+    {
+      MIN,
+      MAX,
+      MEAN,
+      STDDEV,
+      RMS,
+    };
+    static const uint8_t STAT_KIND_COUNT = 5;
+    // Quantities summarised: the first channel slots, current and power
+    static const uint8_t STAT_SLOT_COUNT = 2;
+    static_assert((uint8_t) ChannelSlot::CURRENT < STAT_SLOT_COUNT && (uint8_t) ChannelSlot::POWER < STAT_SLOT_COUNT,
+                  "current and power must have statistics");
+
+    // Min, max, mean and variance of a stream of readings in constant memory (Welford's method)
+    struct RunningStats
+    {
+      uint32_t count{0};
+      float min{NAN};
+      float max{NAN};
+      double mean{0};
+      // Sum of squared differences from the mean
+      double m2{0};
+
+      void add(float value)
+      {
+        if (std::isnan(value))
+        {
+          return;
+        }
+        if (this->count == 0 || value < this->min)
+        {
+          this->min = value;
+        }
+        if (this->count == 0 || value > this->max)
+        {
+          this->max = value;
+        }
+        this->count++;
+        double delta = value - this->mean;
+        this->mean += delta / this->count;
+        this->m2 += delta * (value - this->mean);
+      }
+      // Population variance of the window
+      double variance() const { return this->count == 0 ? 0 : this->m2 / this->count; }
+      float get(StatKind kind) const
+      {
+        if (this->count == 0)
+        {
+          return NAN;
+        }
+        switch (kind)
+        {
+        case StatKind::MIN:
+          return this->min;
+        case StatKind::MAX:
+          return this->max;
+        case StatKind::MEAN:
+          return this->mean;
+        case StatKind::STDDEV:
+          return std::sqrt(this->variance());
+        case StatKind::RMS:
+          return std::sqrt(this->variance() + this->mean * this->mean);
+        }
+        return NAN;
+      }
+    };
+
+    // Statistics of all channels, indexed by [slot][channel - 1]
+    struct ChannelStatistics
+    {
+      sensor::Sensor *sensors[STAT_SLOT_COUNT][STAT_KIND_COUNT][BL0910_CHANNEL_COUNT]{};
+      RunningStats stats[STAT_SLOT_COUNT][BL0910_CHANNEL_COUNT]{};
+      // Slots with a statistics sensor, bit n for ChannelSlot n
+      uint8_t slots[BL0910_CHANNEL_COUNT]{};
+    };
+
+    // CF pulse counters: one per channel, then the sum
+    static const uint8_t BL0910_ENERGY_COUNTERS = BL0910_CHANNEL_COUNT + 1;
+
+    // Energy of the CF pulse counters, kept monotonic across counter wraps, chip resets and
+    // reboots. Saved to flash as is.
+    struct EnergyStore
+    {
+      // Pulses accumulated since the meter started
+      uint64_t pulses[BL0910_ENERGY_COUNTERS];
+      // Counter value the pulses are accumulated up to
+      uint32_t counts[BL0910_ENERGY_COUNTERS];
+    };
+
+    // Calibration registers of a channel
+    enum class CalibrationKind : uint8_t
+    {
+      CURRENT_OFFSET, // RMSOS_n
+      CURRENT_GAIN,   // RMSGN_n
+      POWER_GAIN,     // WATTGN_n
+    };
+    static const uint8_t CALIBRATION_KIND_COUNT = 3;
+
+    // Calibration register values of all channels, indexed by [kind][channel - 1]. Saved to flash as is.
+    struct CalibrationStore
+    {
+      int32_t values[CALIBRATION_KIND_COUNT][BL0910_CHANNEL_COUNT];
+    };
+
+    // Bus work queued by actions, run by the component between register groups
+    enum class CommandType : uint8_t
+    {
+      RESET_ENERGY,
+      WRITE_REGISTER,   // target is the address
+      CALIBRATE,        // target is the channel, 1-10
+      CAPTURE_WAVEFORM, // start a waveform capture now
+      DUMP_TRACE,       // log the recorded frames
+    };
+    struct Command
+    {
+      CommandType type;
+      uint8_t target{0};
+      CalibrationKind kind{CalibrationKind::CURRENT_GAIN};
+      int32_t value{0};
+      float reference{0};
+    };
+    // Commands waiting at most, a full ring drops new ones
+    static const uint8_t COMMAND_QUEUE_SIZE = 16;
+
+    // One register read in the polling schedule
+    struct ReadStep
+    {
+      const RegisterDescriptor *reg{nullptr};
+      sensor::Sensor *sensor{nullptr};
+      // Channel derived values are computed once this reply is in
+      bool last_in_channel{false};
+      // Register group the read belongs to: 0 for the chip-wide registers, n for channel n
+      uint8_t group{0};
+      // Overload watch read: checked against the channel limits only, never published
+      bool watch{false};
+    };
+
+    // Overload limit of a channel's current or power. Trips above threshold, and trips again
+    // only once the value has fallen below release.
+    struct WatchLimit
+    {
+      float threshold{NAN};
+      float release{NAN};
+      bool tripped{false};
+    };
+    // Watched quantities: current and power, in ChannelSlot order
+    static const uint8_t WATCH_SLOT_COUNT = 2;
+
+    // Waveform capture channel for the line voltage, channels 1-10 are the currents
+    static const uint8_t WAVEFORM_VOLTAGE = BL0910_CHANNEL_COUNT + 1;
+
+    // Register groups of the schedule: the chip-wide registers, then one per channel
+    static const uint8_t BL0910_GROUP_COUNT = BL0910_CHANNEL_COUNT + 1;
+
+    // Polling state of a register group in adaptive mode
+    struct GroupPolling
+    {
+      // Reads the group takes per sweep, 0 if it is not polled
+      uint8_t reads{0};
+      // Time the group was last selected, and how long it may wait until the next read
+      uint32_t last_read{0};
+      uint32_t interval{0};
+      // Activity reading at the last read: power, current or voltage
+      float last_value{NAN};
+    };
+
+    // A read command sent and waiting for its reply
+    struct InFlightRead
+    {
+      ReadStep step{};
+      uint32_t sent_at{0};
+    };
+
+    // Distribution of durations in constant memory: exact below 4 us, then four buckets per octave
+    // (about 19% wide) up to 2 s, longer ones land in the last bucket
+    struct DurationHistogram
+    {
+      static const uint8_t BUCKET_COUNT = 84;
+
+      uint32_t counts[BUCKET_COUNT]{};
+      uint32_t total{0};
+      uint32_t max{0};
+
+      void add(uint32_t us);
+      // Upper bound (us) of the bucket holding the given fraction of the durations, 0 if empty
+      uint32_t percentile(float fraction) const;
+    };
+
+    // Bus health sensors of a chip
+    enum class DiagnosticSlot : uint8_t
+    {
+      FRAMES,          // frames sent since boot, reads and writes
+      BYTES,           // bytes on the wire since boot, both directions
+      CHECKSUM_ERRORS, // replies with a bad checksum since boot
+      TIMEOUTS,        // replies that never came since boot
+      RETRIES,         // failed reads sent again since boot
+      DISCARDED_READS, // reads abandoned behind a bad reply or a timeout since boot
+      LOOP_TIME_P50,   // loop() blocking time over the diagnostics interval
+      LOOP_TIME_P99,
+      LOOP_TIME_MAX,
+      SWEEP_DURATION,  // first read of the last sweep to its last reply
+      DATA_RATE,       // SPI clock in use, kHz
+    };
+    static const uint8_t DIAGNOSTIC_SLOT_COUNT = 11;
+
+    // Bus and loop() health of a chip
+    struct BusDiagnostics
+    {
+      uint64_t frames{0};
+      uint64_t bytes{0};
+      uint32_t checksum_errors{0};
+      uint32_t timeouts{0};
+      uint32_t retries{0};
+      uint32_t discarded_reads{0};
+      // Overload watch reads that failed, kept apart from the sweep's reads
+      uint32_t watch_failures{0};
+      // loop() blocking time since boot, and its distribution over the current interval
+      uint32_t loop_count{0};
+      uint64_t loop_total_us{0};
+      uint32_t loop_max_us{0};
+      DurationHistogram loop_time;
+      // Start of the running sweep, until its last reply is in
+      uint32_t sweep_start{0};
+      bool sweep_running{false};
+      uint32_t last_sweep_us{0};
+      uint32_t max_sweep_us{0};
+      uint32_t sweeps{0};
+
+      void sent(uint32_t frame_count, uint32_t byte_count)
+      {
+        this->frames += frame_count;
+        this->bytes += byte_count;
+      }
+      void add_loop_time(uint32_t us)
+      {
+        this->loop_count++;
+        this->loop_total_us += us;
+        if (us > this->loop_max_us)
+        {
+          this->loop_max_us = us;
+        }
+        this->loop_time.add(us);
+      }
+    };
+
+    // Self-tuning of the SPI clock: up one rate while checksum errors stay within the budget, down
+    // one as soon as they exceed it
+    struct DataRateTuning
+    {
+      bool enabled{false};
+      uint32_t min_rate{0};
+      uint32_t max_rate{0};
+      // Checksum errors allowed per frame
+      float max_error_rate{0.001f};
+      // Diagnostics counters at the start of the evaluation window
+      uint64_t window_frames{0};
+      uint32_t window_errors{0};
+      // Rate that failed last, not tried again before retry_at. The wait doubles on each failure.
+      uint32_t failed_rate{0};
+      uint32_t retry_at{0};
+      uint32_t holdoff{0};
+    };
+
+    // Longest polling schedule: every table register plus a snapshot voltage read per channel
+    static const uint8_t BL0910_MAX_SCHEDULE = BL0910_REGISTER_COUNT + BL0910_CHANNEL_COUNT;
+
+    // Most read commands outstanding at once on UART
+    static const uint8_t MAX_PIPELINE_DEPTH = 8;
+
+    // Recovery from bad replies: failed reads are sent again within a budget per sweep, the UART
+    // stream is re-framed, and a chip that gives no valid reply sits out sweeps
+    struct ReadRecovery
+    {
+      uint8_t budget{4};
+      uint8_t retries_left{0};
+      // UART: failed reads to send again ahead of the rest of the sweep, oldest first
+      ReadStep queue[MAX_PIPELINE_DEPTH];
+      uint8_t queued{0};
+      // UART: no command goes out until the line has been quiet since last_byte
+      bool resyncing{false};
+      uint32_t last_byte{0};
+      // Reads that failed for good in a row, the rest of the sweep is given up at a limit
+      uint8_t failures_in_row{0};
+      // Valid replies and reads failed for good in the current sweep
+      uint16_t replies{0};
+      uint16_t failures{0};
+      // Sweeps in a row without one valid reply, sweeps left to sit out, and whether this one is
+      uint8_t silent_sweeps{0};
+      uint8_t skip_sweeps{0};
+      bool skipping{false};
     };
 
     // Forward declarations
-    template <typename... Ts>
-    class ResetEnergyAction;
-    class BL0910;
-    using ActionCallbackFuncPtr = void (BL0910::*)();
+    class BL0910Hub;
 
-    // Base class that will handle the common functionality
+    // Base class that will handle the common functionality: sensors, the read schedule,
+    // conversion and publishing. Bus framing lives in BL0910Core.
     class BL0910 : public PollingComponent
     {
       SUB_SENSOR(voltage)
-      SUB_SENSOR(current_1)
-      SUB_SENSOR(current_2)
-      SUB_SENSOR(current_3)
-      SUB_SENSOR(current_4)
-      SUB_SENSOR(current_5)
-      SUB_SENSOR(current_6)
-      SUB_SENSOR(current_7)
-      SUB_SENSOR(current_8)
-      SUB_SENSOR(current_9)
-      SUB_SENSOR(current_10)
-      SUB_SENSOR(power_1)
-      SUB_SENSOR(power_2)
-      SUB_SENSOR(power_3)
-      SUB_SENSOR(power_4)
-      SUB_SENSOR(power_5)
-      SUB_SENSOR(power_6)
-      SUB_SENSOR(power_7)
-      SUB_SENSOR(power_8)
-      SUB_SENSOR(power_9)
-      SUB_SENSOR(power_10)
       SUB_SENSOR(total_power)
-      SUB_SENSOR(power_factor_1)
-      SUB_SENSOR(power_factor_2)
-      SUB_SENSOR(power_factor_3)
-      SUB_SENSOR(power_factor_4)
-      SUB_SENSOR(power_factor_5)
-      SUB_SENSOR(power_factor_6)
-      SUB_SENSOR(power_factor_7)
-      SUB_SENSOR(power_factor_8)
-      SUB_SENSOR(power_factor_9)
-      SUB_SENSOR(power_factor_10)
-      SUB_SENSOR(energy_1)
-      SUB_SENSOR(energy_2)
-      SUB_SENSOR(energy_3)
-      SUB_SENSOR(energy_4)
-      SUB_SENSOR(energy_5)
-      SUB_SENSOR(energy_6)
-      SUB_SENSOR(energy_7)
-      SUB_SENSOR(energy_8)
-      SUB_SENSOR(energy_9)
-      SUB_SENSOR(energy_10)
       SUB_SENSOR(total_energy)
       SUB_SENSOR(frequency)
       SUB_SENSOR(temperature)
+      SUB_SENSOR(thd)
 
     public:
       void update() override;
-      void dump_config() override;
-      
-      // Set communication mode
-      void set_comm_mode(CommunicationMode mode) { this->comm_mode_ = mode; }
-      
-      // Get communication mode
-      CommunicationMode get_comm_mode() const { return this->comm_mode_; }
+      void on_shutdown() override;
+
+      // Queue bus work, run between register groups. Safe from any task or ISR. Returns false if
+      // the queue is full.
+      bool enqueue_command(const Command &command) { return this->commands_.push(command); }
+
+      // Time loop() may keep sending and collecting reads before returning to the main loop
+      void set_loop_budget(uint32_t budget_us) { this->loop_budget_us_ = budget_us; }
+      // Read commands sent ahead of their replies in UART mode, 1 for strict request/response
+      void set_pipeline_depth(uint8_t depth) { this->pipeline_depth_ = depth; }
+      // Read a whole channel in one SPI chip select assertion
+      void set_spi_burst(bool burst) { this->spi_burst_ = burst; }
+      // channel is 1-10
+      void set_channel_sensor(uint8_t channel, ChannelSlot slot, sensor::Sensor *sensor)
+      {
+        this->channels_.sensors[(uint8_t) slot][channel - 1] = sensor;
+      }
+      // Summary of a channel's current or power, published once per statistics window
+      void set_channel_statistics_sensor(uint8_t channel, ChannelSlot slot, StatKind kind, sensor::Sensor *sensor)
+      {
+        this->statistics_.sensors[(uint8_t) slot][(uint8_t) kind][channel - 1] = sensor;
+        this->statistics_.slots[channel - 1] |= 1 << (uint8_t) slot;
+      }
+      void set_statistics_window(uint32_t window_ms) { this->statistics_window_ = window_ms; }
+      // Poll changing channels on every update and steady ones less often, but each at least once per
+      // max_staleness. At most max_reads register reads per update, 0 for no limit.
+      void set_adaptive_polling(uint32_t max_staleness_ms, float change_ratio, uint8_t max_reads)
+      {
+        this->adaptive_ = true;
+        this->max_staleness_ = max_staleness_ms;
+        this->change_ratio_ = change_ratio;
+        this->max_reads_per_sweep_ = max_reads;
+        // Nothing was read before the first sweep
+        this->sweep_groups_ = 0;
+      }
+      // Overload limit of a channel, slot is CURRENT (A) or POWER (W, either direction)
+      void set_overload_limit(uint8_t channel, ChannelSlot slot, float threshold, float hysteresis)
+      {
+        WatchLimit &limit = this->limits_[(uint8_t) slot][channel - 1];
+        limit.threshold = threshold;
+        limit.release = threshold - hysteresis;
+      }
+      // Armed channels are read this often between register groups, on top of the regular sweep
+      void set_watch_interval(uint32_t interval_us) { this->watch_interval_us_ = interval_us; }
+      void add_on_overcurrent_callback(std::function<void(uint8_t, float)> &&callback)
+      {
+        this->overcurrent_callback_.add(std::move(callback));
+      }
+      void add_on_overpower_callback(std::function<void(uint8_t, float)> &&callback)
+      {
+        this->overpower_callback_.add(std::move(callback));
+      }
+      // Record the latest capacity frames exchanged with the chip, see trace.h
+      void set_trace_capacity(uint16_t capacity) { this->trace_capacity_ = capacity; }
+      // Each sweep's readings packed into one binary frame, see telemetry.h. The callback gets the
+      // frame's buffer, valid until it returns.
+      void set_telemetry_chip(uint8_t chip) { this->telemetry_chip_ = chip; }
+      void add_on_telemetry_callback(std::function<void(const uint8_t *, size_t)> &&callback)
+      {
+        this->telemetry_enabled_ = true;
+        this->telemetry_callback_.add(std::move(callback));
+      }
+      // Capture a channel's waveform (WAVEFORM_VOLTAGE for the voltage) every interval_ms while the
+      // bus is idle, as segments of samples each read sample_interval_us apart (0 = as fast as the
+      // bus allows). Harmonics up to max_harmonic are averaged over the segments.
+      void set_waveform_capture(uint8_t channel, uint16_t samples, uint32_t sample_interval_us, uint8_t segments,
+                                uint32_t interval_ms, uint8_t max_harmonic)
+      {
+        this->waveform_channel_ = channel;
+        this->waveform_samples_ = samples;
+        this->waveform_sample_interval_us_ = sample_interval_us;
+        this->waveform_segments_ = segments;
+        this->waveform_interval_ = interval_ms;
+        this->max_harmonic_ = max_harmonic;
+      }
+      // Harmonic of order 2-15 in percent of the fundamental
+      void set_harmonic_sensor(uint8_t order, sensor::Sensor *sensor) { this->harmonic_sensors_[order] = sensor; }
+      // Deadbands and publish intervals, for a chip-wide sensor or a channel sensor
+      void set_publish_policy(SensorSlot slot, const PublishPolicy &policy)
+      {
+        this->gates_[(uint8_t) slot] = new PublishGate{policy}; // NOLINT(cppcoreguidelines-owning-memory)
+      }
+      void set_channel_publish_policy(uint8_t channel, ChannelSlot slot, const PublishPolicy &policy)
+      {
+        this->channels_.gates[(uint8_t) slot][channel - 1] = new PublishGate{policy}; // NOLINT(cppcoreguidelines-owning-memory)
+      }
+      // Read voltage with each channel's current and power, so power factor and apparent
+      // power come from one consistent V/I/P snapshot
+      void set_snapshot_sampling(bool snapshot) { this->snapshot_sampling_ = snapshot; }
+      // Below this apparent power (VA) a channel is considered unloaded and its power factor undefined
+      void set_min_apparent_power(float min_apparent_power) { this->min_apparent_power_ = min_apparent_power; }
+      // Keep accumulated energy in flash across reboots
+      void set_restore_energy(bool restore) { this->restore_energy_ = restore; }
+      void set_energy_preference_key(const std::string &key) { this->energy_key_ = fnv1_hash("bl0910_energy_" + key); }
+      // Save once this much energy (Wh, all counters together) is unsaved, or once the interval has passed
+      void set_energy_save_threshold(float threshold_wh) { this->energy_save_threshold_ = threshold_wh / 1000.0f; }
+      void set_energy_save_interval(uint32_t interval_ms) { this->energy_save_interval_ = interval_ms; }
+      // Read back one calibrated register this often, and restore them all if the chip lost them (0 = never)
+      void set_verify_interval(uint32_t interval_ms) { this->verify_interval_ = interval_ms; }
+      void set_calibration_preference_key(const std::string &key)
+      {
+        this->calibration_key_ = fnv1_hash("bl0910_calibration_" + key);
+      }
+      // Bus health, published once per diagnostics interval
+      void set_diagnostic_sensor(DiagnosticSlot slot, sensor::Sensor *sensor)
+      {
+        this->diagnostic_sensors_[(uint8_t) slot] = sensor;
+      }
+      void set_diagnostics_interval(uint32_t interval_ms) { this->diagnostics_interval_ = interval_ms; }
+      // Bus counters and timings, and sensor publishes since boot, e.g. for benchmarks
+      const BusDiagnostics &get_diagnostics() const { return this->diagnostics_; }
+      uint32_t get_publish_count() const { return this->publish_count_; }
+      // Failed reads sent again per update at most
+      void set_retry_budget(uint8_t retries) { this->recovery_.budget = retries; }
+      // SPI only: tune the clock between min_rate and max_rate (Hz), keeping checksum errors per
+      // frame within max_error_rate
+      void set_data_rate_tuning(uint32_t min_rate, uint32_t max_rate, float max_error_rate)
+      {
+        this->tuning_.enabled = true;
+        this->tuning_.min_rate = min_rate;
+        this->tuning_.max_rate = max_rate;
+        this->tuning_.max_error_rate = max_error_rate;
+      }
+      // Channels that are polled at all: bit n for channel n, bit 0 for the chip-wide registers
+      void set_channel_mask(uint16_t mask) { this->channel_mask_ = mask; }
 
     protected:
-      template <typename... Ts>
-      friend class ResetEnergyAction;
-      
-      // Pure virtual methods for communication that derived classes must implement
-      virtual void write_byte(uint8_t data) = 0;
-      virtual uint8_t read_byte() = 0;
-      virtual bool read_array(uint8_t *data, size_t len) = 0;
-      virtual void write_array(const uint8_t *data, size_t len) = 0;
-      virtual void flush() = 0;
-      virtual bool available() = 0;
-      
-      // Common methods used by both communication types
-      void loop() override;
+      friend class BL0910Hub;
+
+      // Implemented by BL0910Core for its transport
+      virtual void reset_energy_() = 0;
+      // SPI only: exchange count consecutive full-duplex frames in one transaction, the
+      // buffer is overwritten with the bytes clocked out by the chip. Used by a hub, once per sweep.
+      virtual void transfer_frames_(uint8_t *frames, size_t count) = 0;
+      // One blocking task while the bus is idle: a waveform segment or a register shadow check.
+      // Returns false if none was due.
+      virtual bool run_idle_task_() = 0;
+      // Write the pending calibration registers as one unlock/write/verify/relock sequence
+      virtual void apply_calibration_() = 0;
+      // Run every queued command, while no reply is outstanding
+      virtual void handle_commands_() = 0;
+      // SPI only: switch the bus clock, between transactions
+      virtual void set_bus_rate_(uint32_t rate) = 0;
+
+      // Common methods used by every transport
       void setup() override;
-      void reset_energy_();
-      void read_data_(uint8_t address, float reference, sensor::Sensor *sensor);
-      void calculate_power_factor_(sensor::Sensor *current_sensor, sensor::Sensor *voltage_sensor, sensor::Sensor *power_sensor, sensor::Sensor *power_factor_sensor);
-      void bias_correction_(uint8_t address, float measurements, float correction);
-      void gain_correction_(uint8_t address, float measurements, float correction);
-      size_t enqueue_action_(ActionCallbackFuncPtr function);
-      void handle_actions_();
+      void build_schedule_();
+      void start_sweep_();
+      sensor::Sensor *sensor_for_(const RegisterDescriptor &reg) const;
+      void finish_channel_(uint8_t channel);
+      void select_groups_(uint32_t now);
+      void adapt_group_(uint8_t group);
+      void skip_unselected_();
+      void build_watch_();
+      bool watch_due_() const;
+      void check_limit_(uint8_t index, uint8_t slot, float value);
+      bool handle_reply_(const ReadStep &step, const DataPacket &buffer);
+      void record_frame_(TraceKind kind, uint8_t address, const DataPacket &data);
+      void dump_trace_();
+      bool take_retry_();
+      bool queue_retry_(const ReadStep &step);
+      void note_reply_(const ReadStep &step);
+      void note_failure_(const ReadStep &step);
+      void process_spi_frames_(const uint8_t *frames, const ReadStep *steps, size_t count);
+      size_t collect_sweep_steps_(ReadStep *steps, size_t max, bool skip_voltage, bool skip_frequency);
+      bool read_data_(const RegisterDescriptor &reg, sensor::Sensor *sensor, const DataPacket &buffer);
+      PublishGate *gate_for_(const RegisterDescriptor &reg) const;
+      void publish_(sensor::Sensor *sensor, float value, PublishGate *gate = nullptr);
+      void derive_channel_power_(uint8_t index);
+      void publish_statistics_(uint32_t now);
+      void end_sweep_();
+      void publish_diagnostics_(uint32_t now);
+      void start_data_rate_tuning_();
+      void tune_data_rate_(uint32_t now);
+      void change_data_rate_(uint32_t rate);
+      bool waveform_due_();
+      void start_capture_();
+      bool verify_due_() const;
+      void analyse_segment_(float sample_rate, float fundamental);
+      float accumulate_energy_(const RegisterDescriptor &reg, uint32_t raw);
+      void clear_energy_();
+      void save_energy_(bool force);
+      bool calibrate_(uint8_t channel, CalibrationKind kind, float reference);
+      uint32_t calibrated_registers_() const;
+      int32_t bias_correction_(uint8_t index, float measured, float expected) const;
+      int32_t gain_correction_(int32_t gain, float measured, float expected) const;
+      void dump_sensors_();
+
+      ChannelArrays channels_;
+      // Publish policies of the chip-wide sensors, indexed by SensorSlot
+      PublishGate *gates_[SENSOR_SLOT_COUNT]{};
+      // Last line voltage and frequency read, before any sensor filters
+      float voltage_{NAN};
+      float frequency_{NAN};
+      bool snapshot_sampling_{false};
+      float min_apparent_power_{1.0f};
+
+      ChannelStatistics statistics_;
+      uint32_t statistics_window_{60000};
+      uint32_t statistics_start_{0};
+      uint32_t last_sweep_start_{0};
+      // Time between the last two sweep starts
+      uint32_t sweep_period_{0};
 
-      CommunicationMode comm_mode_{CommunicationMode::UART};
+      bool adaptive_{false};
+      uint32_t max_staleness_{30000};
+      float change_ratio_{0.05f};
+      uint8_t max_reads_per_sweep_{0};
+      GroupPolling groups_[BL0910_GROUP_COUNT];
+      // A channel changed since the chip-wide group was last read
+      bool channel_activity_{false};
+      // Groups read in the current sweep, bit n for group n
+      uint16_t sweep_groups_{0xFFFF};
 
-    private:
-      std::vector<ActionCallbackFuncPtr> action_queue_{};
-      uint8_t current_channel_{0};
-      uint8_t read_buffer_[64];
+      WatchLimit limits_[WATCH_SLOT_COUNT][BL0910_CHANNEL_COUNT];
+      // Current and power reads of the armed channels, built once in setup()
+      ReadStep watch_[WATCH_SLOT_COUNT * BL0910_CHANNEL_COUNT];
+      uint8_t watch_size_{0};
+      // Next watch read to issue, watch_size_ when no watch pass is running
+      uint8_t watch_index_{0};
+      uint32_t watch_interval_us_{100000};
+      uint32_t last_watch_{0};
+      CallbackManager<void(uint8_t, float)> overcurrent_callback_;
+      CallbackManager<void(uint8_t, float)> overpower_callback_;
+
+      // Telemetry frame of the current sweep, sent once the sweep is done
+      bool telemetry_enabled_{false};
+      uint8_t telemetry_chip_{0};
+      uint32_t telemetry_sequence_{0};
+      TelemetryFrame telemetry_;
+      CallbackManager<void(const uint8_t *, size_t)> telemetry_callback_;
+
+      // Frames exchanged with the chip, waveform samples excepted; empty if not configured
+      TraceRing trace_;
+      uint16_t trace_capacity_{0};
+
+      // Waveform channel, 0 when capture is off
+      uint8_t waveform_channel_{0};
+      uint16_t waveform_samples_{256};
+      uint32_t waveform_sample_interval_us_{0};
+      uint8_t waveform_segments_{4};
+      uint32_t waveform_interval_{60000};
+      uint8_t max_harmonic_{WAVEFORM_MAX_HARMONIC};
+      // Segments captured so far, waveform_segments_ when no capture is running
+      uint8_t waveform_segment_{0};
+      uint32_t last_capture_{0};
+      // Samples of the current segment, storage allocated once in setup()
+      WaveformRing waveform_;
+      HarmonicAnalyzer harmonics_;
+      sensor::Sensor *harmonic_sensors_[WAVEFORM_MAX_HARMONIC + 1]{};
+
+      EnergyStore energy_{};
+      // Counters whose next read only sets the baseline, bit n for counter n
+      uint16_t energy_rebaseline_{0};
+      bool restore_energy_{false};
+      uint32_t energy_key_{0};
+      ESPPreferenceObject energy_pref_;
+      // kWh accumulated by all counters since the last save
+      float unsaved_energy_{0};
+      float energy_save_threshold_{0.01f};
+      uint32_t energy_save_interval_{600000};
+      uint32_t last_energy_save_{0};
+      bool energy_save_pending_{false};
+
+      // Shadow of the calibration registers: what the chip holds once the dirty ones are written
+      CalibrationStore calibration_{};
+      // Calibration registers not yet written, or written and read back wrong, bit kind * 10 + channel - 1
+      uint32_t calibration_dirty_{0};
+      // Calibration registers written and not yet read back, one per idle loop()
+      uint32_t calibration_unverified_{0};
+      uint32_t calibration_key_{0};
+      ESPPreferenceObject calibration_pref_;
+      // Last value written to USR_WRPROT, -1 when unknown
+      int32_t write_protection_{-1};
+      // One calibrated register is read back per interval to detect a chip reset
+      uint32_t verify_interval_{60000};
+      uint32_t last_verify_{0};
+      uint8_t verify_index_{0};
+
+      BusDiagnostics diagnostics_;
+      sensor::Sensor *diagnostic_sensors_[DIAGNOSTIC_SLOT_COUNT]{};
+      uint32_t diagnostics_interval_{60000};
+      uint32_t diagnostics_start_{0};
+      // SPI clock in use, 0 on UART
+      uint32_t bus_rate_{0};
+      DataRateTuning tuning_;
+      ReadRecovery recovery_;
+
+      // Set when a hub schedules this chip's reads instead of its own loop()/update()
+      BL0910Hub *hub_{nullptr};
+      // Number of sensor publishes since boot, and readings held back by a publish policy
+      uint32_t publish_count_{0};
+      uint32_t suppressed_count_{0};
+
+      CommandRing<Command, COMMAND_QUEUE_SIZE> commands_;
+      uint32_t loop_budget_us_{1000};
+
+      uint16_t channel_mask_{0xFFFF};
+      // Every read of a sweep in order, built once in setup()
+      ReadStep schedule_[BL0910_MAX_SCHEDULE];
+      uint8_t schedule_size_{0};
+      // Next read of the sweep to issue, schedule_size_ once the sweep is issued
+      uint8_t sweep_index_{0};
+
+      // Reads sent and waiting for their replies, oldest first
+      InFlightRead inflight_[MAX_PIPELINE_DEPTH];
+      uint8_t inflight_head_{0};
+      uint8_t inflight_count_{0};
+      uint8_t pipeline_depth_{4};
+
+      // SPI frames of the current transaction, one register group at most
+      uint8_t spi_frames_[BL0910_FRAME_SIZE * BL0910_MAX_GROUP_SIZE];
+      static_assert(WATCH_SLOT_COUNT <= BL0910_MAX_GROUP_SIZE, "a channel's watch reads must fit one SPI burst");
+      bool spi_burst_{false};
+    };
+
+    // Protocol core, bound at compile time to a transport (CRTP). The transport provides
+    // SPI_FRAMING and, for UART framing, bus_write_(), bus_read_(), bus_available_() and
+    // bus_flush_(); for SPI framing, bus_transfer_(), bus_data_rate_() and bus_set_data_rate_().
+    // Framing, byte order and the read/write sequences resolve per transport, with no indirect
+    // call per byte.
+    template <typename Transport>
+    class BL0910Core : public BL0910
+    {
+    public:
+      void loop() override;
+      void dump_config() override;
+
+    protected:
+      Transport *transport_() { return static_cast<Transport *>(this); }
+
+      bool issue_next_();
+      uint8_t read_spi_frames_(const ReadStep *steps);
+      void send_request_(const ReadStep &step);
+      bool receive_reply_();
+      void recover_(const ReadStep &failed);
+      bool resync_done_();
+      void discard_input_();
+      void reset_energy_() override;
+      void transfer_frames_(uint8_t *frames, size_t count) override;
+      bool run_idle_task_() override;
+      void capture_segment_();
+      void verify_shadow_();
+      void verify_calibration_();
+      void apply_calibration_() override;
+      void handle_commands_() override;
+      void set_bus_rate_(uint32_t rate) override;
+      void set_write_protection_(uint32_t value);
+      bool read_register_(uint8_t address, uint32_t &value);
+      void write_register_(uint8_t address, int32_t value);
     };
 
     // UART specific implementation
-    class BL0910UART : public BL0910, public uart::UARTDevice {
+    class BL0910UART : public BL0910Core<BL0910UART>, public uart::UARTDevice
+    {
+    protected:
+      friend class BL0910Core<BL0910UART>;
+      static constexpr bool SPI_FRAMING = false;
+
+      void bus_write_(const uint8_t *data, size_t len) { this->write_array(data, len); }
+      bool bus_read_(uint8_t *data, size_t len) { return this->read_array(data, len); }
+      int bus_available_() { return this->available(); }
+      void bus_flush_() { this->flush(); }
+    };
+
+    // SPI specific implementation. DATA_RATE_1MHZ is only the default, data_rate sets the clock per
+    // instance and tuning changes it at run time.
+    class BL0910SPI : public BL0910Core<BL0910SPI>, public spi::SPIDevice<spi::BIT_ORDER_MSB_FIRST,
+                                                                          spi::CLOCK_POLARITY_LOW,
+                                                                          spi::CLOCK_PHASE_LEADING,
+                                                                          spi::DATA_RATE_1MHZ>
+    {
     public:
-      void write_byte(uint8_t data) override { UARTDevice::write_byte(data); }
-      uint8_t read_byte() override { uint8_t data; UARTDevice::read_byte(&data); return data; }
-      bool read_array(uint8_t *data, size_t len) override { return UARTDevice::read_array(data, len); }
-      void write_array(const uint8_t *data, size_t len) override { UARTDevice::write_array(data, len); }
-      void flush() override { UARTDevice::flush(); }
-      bool available() override { return UARTDevice::available(); }
-    };
-
-    // SPI specific implementation
-    class BL0910SPI : public BL0910, public spi::SPIDevice<spi::BIT_ORDER_MSB_FIRST, 
-                                                          spi::CLOCK_POLARITY_LOW,
-                                                          spi::CLOCK_PHASE_LEADING, 
-                                                          spi::DATA_RATE_1MHZ> {
+      void setup() override;
+
+    protected:
+      friend class BL0910Core<BL0910SPI>;
+      static constexpr bool SPI_FRAMING = true;
+
+      void bus_transfer_(uint8_t *frames, size_t count)
+      {
+        // One chip select assertion and one bus transfer for all frames
+        this->enable();
+        this->transfer_array(frames, count * BL0910_FRAME_SIZE);
+        this->disable();
+      }
+      uint32_t bus_data_rate_() const { return this->data_rate_; }
+      void bus_set_data_rate_(uint32_t rate)
+      {
+        // The SPI component applies a device's clock when the device registers
+        this->spi_teardown();
+        this->set_data_rate(rate);
+        this->spi_setup();
+      }
+    };
+
+    // Emulated chip behind UART or SPI framing, for running the polling cycle without hardware
+    // (e.g. on the host platform)
+    template <bool SPI>
+    class BL0910Emulated : public BL0910Core<BL0910Emulated<SPI>>
+    {
     public:
-      void write_byte(uint8_t data) override;
-      uint8_t read_byte() override;
-      bool read_array(uint8_t *data, size_t len) override;
-      void write_array(const uint8_t *data, size_t len) override;
-      void flush() override;
-      bool available() override;
-      
+      void setup() override;
+      void update() override;
+      void dump_config() override;
+
+      void set_emulator_config(const EmulatorConfig &config) { this->emulator_.set_config(config); }
+      // Replay a trace dumped by bl0910.dump_trace, see BL0910Emulator::load_replay()
+      void set_emulator_replay(const char *trace) { this->emulator_.load_replay(trace); }
+      BL0910Emulator &get_emulator() { return this->emulator_; }
+
     protected:
-      // Buffer for SPI reading/writing
-      std::vector<uint8_t> rx_buffer_;
+      friend class BL0910Core<BL0910Emulated<SPI>>;
+      static constexpr bool SPI_FRAMING = SPI;
+
+      void bus_write_(const uint8_t *data, size_t len) { this->emulator_.receive(data, len); }
+      bool bus_read_(uint8_t *data, size_t len);
+      int bus_available_() { return this->emulator_.available(); }
+      // Like UART flush(), waits for TX only; emulated TX completes immediately
+      void bus_flush_() {}
+      // Takes its wire time at the emulated clock, as a real SPI transfer blocks for it
+      void bus_transfer_(uint8_t *frames, size_t count)
+      {
+        uint32_t start = micros();
+        this->emulator_.transfer(frames, count * BL0910_FRAME_SIZE);
+        uint32_t clock = this->emulator_.get_config().spi_clock_hz;
+        uint32_t wire_us = clock == 0 ? 0 : (uint32_t) (count * BL0910_FRAME_SIZE * 8 * 1000000ULL / clock);
+        while (micros() - start < wire_us)
+        {
+        }
+      }
+      uint32_t bus_data_rate_() const { return this->emulator_.get_config().spi_clock_hz; }
+      void bus_set_data_rate_(uint32_t rate) { this->emulator_.set_spi_clock(rate); }
+
+      void log_stats_();
+
+      BL0910Emulator emulator_;
     };
 
+    using BL0910EmulatedUART = BL0910Emulated<false>;
+    using BL0910EmulatedSPI = BL0910Emulated<true>;
+
+    // Instantiated once, in bl0910.cpp
+    extern template class BL0910Core<BL0910UART>;
+    extern template class BL0910Core<BL0910SPI>;
+    extern template class BL0910Core<BL0910EmulatedUART>;
+    extern template class BL0910Core<BL0910EmulatedSPI>;
+    extern template class BL0910Emulated<false>;
+    extern template class BL0910Emulated<true>;
+
     template <typename... Ts>
     class ResetEnergyAction : public Action<Ts...>, public Parented<BL0910>
     {
     public:
-      void play(Ts... x) override { this->parent_->enqueue_action_(&BL0910::reset_energy_); }
+      void play(Ts... x) override { this->parent_->enqueue_command(Command{CommandType::RESET_ENERGY}); }
+    };
+
+    // Correct a channel's offset or gain so that its reading becomes the reference
+    template <typename... Ts>
+    class CalibrateAction : public Action<Ts...>, public Parented<BL0910>
+    {
+    public:
+      TEMPLATABLE_VALUE(uint8_t, channel)
+      TEMPLATABLE_VALUE(float, reference)
+
+      void set_kind(CalibrationKind kind) { this->kind_ = kind; }
+      void play(Ts... x) override
+      {
+        this->parent_->enqueue_command(
+            Command{CommandType::CALIBRATE, this->channel_.value(x...), this->kind_, 0, this->reference_.value(x...)});
+      }
+
+    protected:
+      CalibrationKind kind_{CalibrationKind::CURRENT_GAIN};
+    };
+
+    // Write a raw value to a user register, with write protection lifted for the write
+    template <typename... Ts>
+    class WriteRegisterAction : public Action<Ts...>, public Parented<BL0910>
+    {
+    public:
+      TEMPLATABLE_VALUE(uint8_t, address)
+      TEMPLATABLE_VALUE(int32_t, value)
+
+      void play(Ts... x) override
+      {
+        this->parent_->enqueue_command(Command{CommandType::WRITE_REGISTER, this->address_.value(x...),
+                                               CalibrationKind::CURRENT_GAIN, this->value_.value(x...)});
+      }
+    };
+
+    // Start a waveform capture without waiting for the capture interval
+    template <typename... Ts>
+    class CaptureWaveformAction : public Action<Ts...>, public Parented<BL0910>
+    {
+    public:
+      void play(Ts... x) override { this->parent_->enqueue_command(Command{CommandType::CAPTURE_WAVEFORM}); }
+    };
+
+    // Log the recorded frames, for replay on the host
+    template <typename... Ts>
+    class DumpTraceAction : public Action<Ts...>, public Parented<BL0910>
+    {
+    public:
+      void play(Ts... x) override { this->parent_->enqueue_command(Command{CommandType::DUMP_TRACE}); }
+    };
+
+    // Fires with the channel (1-10) and its current when the overcurrent limit trips
+    class OvercurrentTrigger : public Trigger<uint8_t, float>
+    {
+    public:
+      explicit OvercurrentTrigger(BL0910 *parent)
+      {
+        parent->add_on_overcurrent_callback([this](uint8_t channel, float current) { this->trigger(channel, current); });
+      }
+    };
+
+    // Fires with the channel (1-10) and its power when the overpower limit trips
+    class OverpowerTrigger : public Trigger<uint8_t, float>
+    {
+    public:
+      explicit OverpowerTrigger(BL0910 *parent)
+      {
+        parent->add_on_overpower_callback([this](uint8_t channel, float power) { this->trigger(channel, power); });
+      }
+    };
+
+    // Fires with the telemetry frame of each sweep that read anything. The frame is not copied: data
+    // points into the chip's frame buffer and is only valid during the automation.
+    class TelemetryTrigger : public Trigger<const uint8_t *, size_t>
+    {
+    public:
+      explicit TelemetryTrigger(BL0910 *parent)
+      {
+        parent->add_on_telemetry_callback([this](const uint8_t *data, size_t size) { this->trigger(data, size); });
+      }
     };
 
   } // namespace bl0910
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Fixed-capacity queue of commands for the component's loop. No ESPHome dependencies.
+namespace esphome
+{
+  namespace bl0910
+  {
+    // Bounded multi-producer, single-consumer ring without locks or allocation. Each slot carries a
+    // sequence number telling producers and the consumer whose turn it is. push() is safe from any
+    // task or ISR; pop() only from the one consumer. Capacity must be a power of two.
+    template <typename T, uint8_t N>
+    class CommandRing
+    {
+      static_assert(N != 0 && (N & (N - 1)) == 0, "capacity must be a power of two");
+
+    public:
+      CommandRing()
+      {
+        for (uint32_t i = 0; i < N; i++)
+          this->slots_[i].sequence.store(i, std::memory_order_relaxed);
+      }
+
+      // Returns false, and counts a drop, if the ring is full
+      bool push(const T &value)
+      {
+        uint32_t position = this->tail_.load(std::memory_order_relaxed);
+        Slot *slot;
+        for (;;)
+        {
+          slot = &this->slots_[position % N];
+          int32_t lag = (int32_t) (slot->sequence.load(std::memory_order_acquire) - position);
+          if (lag == 0)
+          {
+            // The slot is free for this position, claim it
+            if (this->tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+              break;
+          }
+          else if (lag < 0)
+          {
+            // The consumer has not freed the slot yet
+            this->dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+          }
+          else
+          {
+            // Another producer took this position
+            position = this->tail_.load(std::memory_order_relaxed);
+          }
+        }
+        slot->value = value;
+        slot->sequence.store(position + 1, std::memory_order_release);
+        return true;
+      }
+
+      // Take the oldest command, returns false if there is none
+      bool pop(T &value)
+      {
+        Slot &slot = this->slots_[this->head_ % N];
+        if ((int32_t) (slot.sequence.load(std::memory_order_acquire) - (this->head_ + 1)) < 0)
+          return false;
+        value = slot.value;
+        slot.sequence.store(this->head_ + N, std::memory_order_release);
+        this->head_++;
+        return true;
+      }
+
+      bool empty() const
+      {
+        const Slot &slot = this->slots_[this->head_ % N];
+        return (int32_t) (slot.sequence.load(std::memory_order_acquire) - (this->head_ + 1)) < 0;
+      }
+
+      // Commands dropped on a full ring since the last call
+      uint32_t take_dropped() { return this->dropped_.exchange(0, std::memory_order_relaxed); }
+
+    protected:
+      struct Slot
+      {
+        std::atomic<uint32_t> sequence;
+        T value;
+      };
+
+      Slot slots_[N];
+      std::atomic<uint32_t> tail_{0};
+      std::atomic<uint32_t> dropped_{0};
+      // Consumer side only
+      uint32_t head_{0};
+    };
+
+  } // namespace bl0910
+} // namespace esphome
@@ -6,18 +6,22 @@ namespace esphome
     namespace bl0910
     {
         // Conversion
-        static const float BL0910_UREF = 109700.0 / (1316200000); // Voltage
-        static const float BL0910_IREF = 1.097 / (12875 * 5.1); // Current
-        static const float BL0910_PREF = 120340.9 / (4041259 * 5.1); // Power
-        static const float BL0910_WATT = 16 * BL0910_PREF; // Total power
-        static const float BL0910_EREF = 4194304 * 0.032768 * 16 / (3600000 * 16 * (404125 * 51 / 120340.9)); // Energy
-        static const float BL0910_CF = 16 * BL0910_EREF; // Total Energy
-        static const float BL0910_FREF = 10000000; // Frequency
-        static const float BL0910_KI = 12875 * 5.1 / 1.097; // Current coefficient
-        static const float BL0910_KP = 40.4125 * 5.1 / 1.097 / 1.097; // Power coefficient
-        static const float BL0910_TREF = 12.5 / 59 - 40; // Temperature
+        static constexpr float BL0910_UREF = 109700.0 / (1316200000); // Voltage
+        static constexpr float BL0910_IREF = 1.097 / (12875 * 5.1); // Current
+        static constexpr float BL0910_PREF = 120340.9 / (4041259 * 5.1); // Power
+        static constexpr float BL0910_WATT = 16 * BL0910_PREF; // Total power
+        static constexpr float BL0910_EREF = 4194304 * 0.032768 * 16 / (3600000 * 16 * (404125 * 51 / 120340.9)); // Energy
+        static constexpr float BL0910_CF = 16 * BL0910_EREF; // Total Energy
+        static constexpr float BL0910_FREF = 10000000; // Frequency
+        static constexpr float BL0910_KI = 12875 * 5.1 / 1.097; // Current coefficient
+        static constexpr float BL0910_KP = 40.4125 * 5.1 / 1.097 / 1.097; // Power coefficient
+        static constexpr float BL0910_TREF = 12.5 / 59 - 40; // Temperature
 
         // Register address
+        // Waveform, instantaneous signed samples: current channels 1-10, then voltage
+        static const uint8_t BL0910_WAVE_1 = 0x01;
+        static const uint8_t BL0910_WAVE_V = 0x0B;
+
         // Voltage
         static const uint8_t BL0910_V_RMS = 0x16;
 
@@ -104,16 +108,136 @@ namespace esphome
 
         // User write protection setting register
         static const uint8_t BL0910_USR_WRPROT = 0x9E;
+        // Write protection values: user registers writable, or read only
+        static const uint32_t BL0910_USR_WRPROT_WRITABLE = 0x5555;
+        static const uint32_t BL0910_USR_WRPROT_READ_ONLY = 0x0000;
         // Reset Register
         static const uint8_t BL0910_SOFT_RESET = 0x9F;
         // You must first write 0x5555 to the write protection setting register before writing to other registers.
         static const uint8_t BL0910_READ_COMMAND = 0x35;  // 读操作命令
         static const uint8_t BL0910_WRITE_COMMAND = 0xCA; // 写操作命令
 
+        // Command, address, three data bytes, checksum
+        static const uint8_t BL0910_FRAME_SIZE = 6;
+
         // SPI frame identifiers
         static const uint8_t BL0910_SPI_READ_COMMAND  = 0x82; // SPI read frame identifier
         static const uint8_t BL0910_SPI_WRITE_COMMAND = 0x81; // SPI write frame identifier
 
+        // Frame checksum: inverted 8-bit sum of the register address and the three data bytes
+        constexpr uint8_t bl0910_frame_checksum(uint8_t address, uint8_t l, uint8_t m, uint8_t h)
+        {
+            return (address + l + m + h) ^ 0xFF;
+        }
+
+        // How a register's raw value becomes a reading
+        enum class Conversion : uint8_t
+        {
+            LINEAR,     // raw * scale + offset
+            RECIPROCAL, // scale / raw
+            COUNTER,    // Wrapping pulse count, accumulated; pulses * scale
+        };
+
+        // The sensor a register feeds: one of its channel's, or a chip-wide one
+        enum class SensorSlot : uint8_t
+        {
+            CURRENT,
+            POWER,
+            ENERGY,
+            TEMPERATURE,
+            FREQUENCY,
+            VOLTAGE,
+            TOTAL_POWER,
+            TOTAL_ENERGY,
+        };
+
+        struct RegisterDescriptor
+        {
+            uint8_t address;
+            uint8_t channel; // 1-10, 0 for chip-wide registers
+            SensorSlot slot;
+            bool is_signed;
+            uint8_t width; // Bits
+            Conversion conversion;
+            float scale;
+            float offset;
+        };
+
+        // Polling schedule in sweep order. Consecutive entries of the same channel are read as one
+        // group; a new register is one more entry here plus its sensor slot.
+        static constexpr RegisterDescriptor BL0910_REGISTERS[] = {
+            // Internal temperature: (raw - 64) * 12.5 / 59 - 40
+            {BL0910_TEMPERATURE, 0, SensorSlot::TEMPERATURE, true, 24, Conversion::LINEAR, 12.5f / 59, -64 * 12.5f / 59 - 40},
+            {BL0910_I_1_RMS, 1, SensorSlot::CURRENT, false, 24, Conversion::LINEAR, BL0910_IREF, 0},
+            {BL0910_WATT_1, 1, SensorSlot::POWER, true, 24, Conversion::LINEAR, BL0910_PREF, 0},
+            {BL0910_CF_1_CNT, 1, SensorSlot::ENERGY, false, 24, Conversion::COUNTER, BL0910_EREF, 0},
+            {BL0910_I_2_RMS, 2, SensorSlot::CURRENT, false, 24, Conversion::LINEAR, BL0910_IREF, 0},
+            {BL0910_WATT_2, 2, SensorSlot::POWER, true, 24, Conversion::LINEAR, BL0910_PREF, 0},
+            {BL0910_CF_2_CNT, 2, SensorSlot::ENERGY, false, 24, Conversion::COUNTER, BL0910_EREF, 0},
+            {BL0910_I_3_RMS, 3, SensorSlot::CURRENT, false, 24, Conversion::LINEAR, BL0910_IREF, 0},
+            {BL0910_WATT_3, 3, SensorSlot::POWER, true, 24, Conversion::LINEAR, BL0910_PREF, 0},
+            {BL0910_CF_3_CNT, 3, SensorSlot::ENERGY, false, 24, Conversion::COUNTER, BL0910_EREF, 0},
+            {BL0910_I_4_RMS, 4, SensorSlot::CURRENT, false, 24, Conversion::LINEAR, BL0910_IREF, 0},
+            {BL0910_WATT_4, 4, SensorSlot::POWER, true, 24, Conversion::LINEAR, BL0910_PREF, 0},
+            {BL0910_CF_4_CNT, 4, SensorSlot::ENERGY, false, 24, Conversion::COUNTER, BL0910_EREF, 0},
+            {BL0910_I_5_RMS, 5, SensorSlot::CURRENT, false, 24, Conversion::LINEAR, BL0910_IREF, 0},
+            {BL0910_WATT_5, 5, SensorSlot::POWER, true, 24, Conversion::LINEAR, BL0910_PREF, 0},
+            {BL0910_CF_5_CNT, 5, SensorSlot::ENERGY, false, 24, Conversion::COUNTER, BL0910_EREF, 0},
+            {BL0910_I_6_RMS, 6, SensorSlot::CURRENT, false, 24, Conversion::LINEAR, BL0910_IREF, 0},
+            {BL0910_WATT_6, 6, SensorSlot::POWER, true, 24, Conversion::LINEAR, BL0910_PREF, 0},
+            {BL0910_CF_6_CNT, 6, SensorSlot::ENERGY, false, 24, Conversion::COUNTER, BL0910_EREF, 0},
+            {BL0910_I_7_RMS, 7, SensorSlot::CURRENT, false, 24, Conversion::LINEAR, BL0910_IREF, 0},
+            {BL0910_WATT_7, 7, SensorSlot::POWER, true, 24, Conversion::LINEAR, BL0910_PREF, 0},
+            {BL0910_CF_7_CNT, 7, SensorSlot::ENERGY, false, 24, Conversion::COUNTER, BL0910_EREF, 0},
+            {BL0910_I_8_RMS, 8, SensorSlot::CURRENT, false, 24, Conversion::LINEAR, BL0910_IREF, 0},
+            {BL0910_WATT_8, 8, SensorSlot::POWER, true, 24, Conversion::LINEAR, BL0910_PREF, 0},
+            {BL0910_CF_8_CNT, 8, SensorSlot::ENERGY, false, 24, Conversion::COUNTER, BL0910_EREF, 0},
+            {BL0910_I_9_RMS, 9, SensorSlot::CURRENT, false, 24, Conversion::LINEAR, BL0910_IREF, 0},
+            {BL0910_WATT_9, 9, SensorSlot::POWER, true, 24, Conversion::LINEAR, BL0910_PREF, 0},
+            {BL0910_CF_9_CNT, 9, SensorSlot::ENERGY, false, 24, Conversion::COUNTER, BL0910_EREF, 0},
+            {BL0910_I_10_RMS, 10, SensorSlot::CURRENT, false, 24, Conversion::LINEAR, BL0910_IREF, 0},
+            {BL0910_WATT_10, 10, SensorSlot::POWER, true, 24, Conversion::LINEAR, BL0910_PREF, 0},
+            {BL0910_CF_10_CNT, 10, SensorSlot::ENERGY, false, 24, Conversion::COUNTER, BL0910_EREF, 0},
+            {BL0910_FREQUENCY, 0, SensorSlot::FREQUENCY, false, 24, Conversion::RECIPROCAL, BL0910_FREF, 0},
+            {BL0910_V_RMS, 0, SensorSlot::VOLTAGE, false, 24, Conversion::LINEAR, BL0910_UREF, 0},
+            {BL0910_WATT_SUM, 0, SensorSlot::TOTAL_POWER, true, 24, Conversion::LINEAR, BL0910_WATT, 0},
+            {BL0910_CF_SUM_CNT, 0, SensorSlot::TOTAL_ENERGY, false, 24, Conversion::COUNTER, BL0910_CF, 0},
+        };
+        // Measurement channels, numbered 1-10
+        static constexpr uint8_t BL0910_CHANNEL_COUNT = 10;
+        static constexpr uint8_t BL0910_REGISTER_COUNT = sizeof(BL0910_REGISTERS) / sizeof(BL0910_REGISTERS[0]);
+        // Table index of the first register feeding a slot
+        constexpr uint8_t bl0910_register_index(SensorSlot slot)
+        {
+            for (uint8_t i = 0; i < BL0910_REGISTER_COUNT; i++)
+            {
+                if (BL0910_REGISTERS[i].slot == slot)
+                {
+                    return i;
+                }
+            }
+            return BL0910_REGISTER_COUNT;
+        }
+        // Reads in the largest register group: a run of consecutive same-channel entries, plus the
+        // voltage read snapshot sampling puts ahead of a channel's registers
+        constexpr uint8_t bl0910_max_group_size()
+        {
+            uint8_t largest = 0;
+            uint8_t run = 0;
+            for (uint8_t i = 0; i < BL0910_REGISTER_COUNT; i++)
+            {
+                bool same_group = i > 0 && BL0910_REGISTERS[i - 1].channel == BL0910_REGISTERS[i].channel;
+                run = same_group ? run + 1 : 1;
+                uint8_t size = run + (BL0910_REGISTERS[i].channel != 0 ? 1 : 0);
+                if (size > largest)
+                {
+                    largest = size;
+                }
+            }
+            return largest;
+        }
+        static constexpr uint8_t BL0910_MAX_GROUP_SIZE = bl0910_max_group_size();
+
         const uint8_t BL0910_INIT[2][6] = {
             // Reset to default
             {BL0910_WRITE_COMMAND, BL0910_SOFT_RESET, 0x5A, 0x5A, 0x5A, 0x52},
@@ -0,0 +1,593 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "constants.h"
+#include "trace.h"
+
+// Register-level model of a BL0910. It has no ESPHome dependencies so the same
+// header drives the `emulator` transport on a device and host-side tools.
+namespace esphome
+{
+  namespace bl0910
+  {
+    // Imperfections applied by the emulated chip
+    struct EmulatorConfig
+    {
+      uint32_t seed{1};             // PRNG seed, the same seed replays the same noise and corruption
+      uint32_t noise_lsb{0};        // Peak noise added to RMS and power registers on every read
+      uint32_t reply_latency_us{0}; // Chip turnaround between the last command byte and the first reply byte
+      uint32_t byte_time_us{0};     // Wire time per byte, 0 models an infinitely fast bus
+      uint32_t corruption_ppm{0};   // Probability of one flipped bit per reply byte, parts per million
+      uint32_t spi_clock_hz{1000000}; // SPI clock the host runs the bus at
+      uint32_t clean_clock_hz{0};   // SPI clock above which replies corrupt more the faster it runs, 0 = no limit
+    };
+
+    // Traffic counters kept by the emulated chip
+    struct EmulatorStats
+    {
+      uint32_t bytes_in{0};        // Host -> chip
+      uint32_t bytes_out{0};       // Chip -> host
+      uint32_t read_frames{0};
+      uint32_t write_frames{0};
+      uint32_t rejected_writes{0}; // Bad checksum or write protected
+      uint32_t corrupted_bytes{0};
+      uint32_t dropped_bytes{0};   // Bytes that did not start a frame
+    };
+
+    class BL0910Emulator
+    {
+    public:
+      using ClockFunc = uint32_t (*)();
+
+      static const size_t REGISTER_COUNT = 256;
+      static const size_t REPLY_BUFFER_SIZE = 64;
+      // Highest harmonic order the waveform registers can carry
+      static const uint8_t MAX_HARMONIC = 15;
+
+      BL0910Emulator() { this->load_defaults(); }
+
+      void set_config(const EmulatorConfig &config)
+      {
+        this->config_ = config;
+        this->rng_ = config.seed != 0 ? config.seed : 1;
+      }
+      const EmulatorConfig &get_config() const { return this->config_; }
+      // SPI framing (0x82/0x81, MSB first) instead of UART framing (0x35/0xCA, LSB first)
+      void set_spi_framing(bool spi) { this->spi_ = spi; }
+      // SPI clock the host switched the bus to
+      void set_spi_clock(uint32_t hz) { this->config_.spi_clock_hz = hz; }
+      // Microsecond clock used for latency and CF pulse accumulation, nullptr freezes time
+      void set_clock(ClockFunc clock) { this->clock_ = clock; }
+
+      const EmulatorStats &get_stats() const { return this->stats_; }
+      void reset_stats() { this->stats_ = EmulatorStats{}; }
+
+      // Power-on register contents: 230 V / 50 Hz, channel n carrying n * 0.5 A at PF 0.9
+      void load_defaults()
+      {
+        for (size_t i = 0; i < REGISTER_COUNT; i++)
+          this->registers_[i] = 0;
+        this->voltage_ = 230.0f;
+        for (uint8_t channel = 0; channel < 10; channel++)
+        {
+          this->current_[channel] = (channel + 1) * 0.5f;
+          this->power_factor_[channel] = 0.9f;
+          this->pulses_[channel] = 0;
+        }
+        for (uint8_t wave = 0; wave < 11; wave++)
+          for (uint8_t order = 0; order <= MAX_HARMONIC; order++)
+            this->harmonics_[wave][order] = 0;
+        this->pulses_sum_ = 0;
+        this->set_frequency(50.0f);
+        this->set_temperature(35.0f);
+        this->write_protected_ = true;
+        this->refresh_measurements_();
+      }
+
+      void set_voltage(float volts)
+      {
+        this->voltage_ = volts;
+        this->refresh_measurements_();
+      }
+      // channel is 1-based, as in the register names
+      void set_channel_load(uint8_t channel, float amps, float power_factor)
+      {
+        if (channel < 1 || channel > 10)
+          return;
+        this->current_[channel - 1] = amps;
+        this->power_factor_[channel - 1] = power_factor;
+        this->refresh_measurements_();
+      }
+      void set_frequency(float hz)
+      {
+        this->frequency_ = hz;
+        this->registers_[BL0910_FREQUENCY] = raw_(BL0910_FREF / hz);
+      }
+      // Harmonic of order 2-15 in a waveform, amplitude relative to the fundamental.
+      // channel is 1-10, 11 for the voltage.
+      void set_harmonic(uint8_t channel, uint8_t order, float ratio)
+      {
+        if (channel < 1 || channel > 11 || order < 2 || order > MAX_HARMONIC)
+          return;
+        this->harmonics_[channel - 1][order] = ratio;
+      }
+      void set_temperature(float celsius) { this->registers_[BL0910_TEMPERATURE] = raw_((celsius + 40) * 59 / 12.5f + 64); }
+
+      void set_register(uint8_t address, uint32_t value)
+      {
+        this->registers_[address] = value & 0xFFFFFF;
+        // Keep the pulse counters in step, otherwise the next accumulation overwrites the write
+        if (address >= BL0910_CF_1_CNT && address < BL0910_CF_1_CNT + 10)
+          this->pulses_[address - BL0910_CF_1_CNT] = value & 0xFFFFFF;
+        else if (address == BL0910_CF_SUM_CNT)
+          this->pulses_sum_ = value & 0xFFFFFF;
+      }
+      uint32_t get_register(uint8_t address) const { return this->registers_[address]; }
+
+      // Answer reads from a recorded trace instead of the model: each read of an address gets the
+      // next reply recorded for it, bad checksums and missing replies included, starting over at
+      // the end. An address the trace never read gets no reply. text is TRACE_TEXT_SIZE hex digits
+      // per record, whitespace between records is skipped. Returns the number of records loaded.
+      size_t load_replay(const char *text)
+      {
+        this->replay_.clear();
+        TraceRecord record;
+        while (*text != '\0')
+        {
+          if (*text == ' ' || *text == '\n' || *text == '\r' || *text == '\t')
+          {
+            text++;
+            continue;
+          }
+          size_t len = 0;
+          while (len < TRACE_TEXT_SIZE && text[len] != '\0')
+            len++;
+          if (len < TRACE_TEXT_SIZE || !parse_trace_record(text, record))
+            break;
+          this->replay_.push_back(record);
+          text += TRACE_TEXT_SIZE;
+        }
+        for (size_t i = 0; i < REGISTER_COUNT; i++)
+          this->replay_cursor_[i] = 0;
+        return this->replay_.size();
+      }
+      size_t replay_size() const { return this->replay_.size(); }
+      bool is_replaying() const { return !this->replay_.empty(); }
+      bool is_write_protected() const { return this->write_protected_; }
+
+      // UART: a byte sent by the host
+      void receive(uint8_t data)
+      {
+        this->stats_.bytes_in++;
+        uint32_t now = this->now_();
+        // The chip only sees the byte once it has been shifted in
+        this->rx_done_ = (this->config_.byte_time_us != 0 && after_(this->rx_done_, now) ? this->rx_done_ : now) + this->config_.byte_time_us;
+        this->parse_(data, this->rx_done_);
+      }
+      void receive(const uint8_t *data, size_t len)
+      {
+        for (size_t i = 0; i < len; i++)
+          this->receive(data[i]);
+      }
+
+      // UART: reply bytes that have fully arrived at the host
+      size_t available() const
+      {
+        if (this->clock_ == nullptr)
+          return this->reply_count_;
+        uint32_t now = this->clock_();
+        size_t count = 0;
+        while (count < this->reply_count_ && !after_(this->reply_ready_[(this->reply_head_ + count) % REPLY_BUFFER_SIZE], now))
+          count++;
+        return count;
+      }
+      // UART: take up to len arrived bytes, returns how many were copied
+      size_t transmit(uint8_t *data, size_t len)
+      {
+        size_t count = this->available();
+        if (count > len)
+          count = len;
+        for (size_t i = 0; i < count; i++)
+        {
+          data[i] = this->reply_[this->reply_head_];
+          this->reply_head_ = (this->reply_head_ + 1) % REPLY_BUFFER_SIZE;
+        }
+        this->reply_count_ -= count;
+        return count;
+      }
+
+      // SPI: one full-duplex byte, host byte in, chip byte out
+      uint8_t transfer(uint8_t data)
+      {
+        this->stats_.bytes_in++;
+        if (this->reply_count_ > 0)
+        {
+          // Shifting out a read reply, MOSI carries dummy bytes
+          uint8_t out = this->reply_[this->reply_head_];
+          this->reply_head_ = (this->reply_head_ + 1) % REPLY_BUFFER_SIZE;
+          this->reply_count_--;
+          return out;
+        }
+        // Six consecutive 0xFF bytes reset the SPI interface
+        if (data != 0xFF)
+          this->ff_run_ = 0;
+        else if (++this->ff_run_ >= 6)
+        {
+          this->ff_run_ = 0;
+          this->state_ = State::IDLE;
+          return 0;
+        }
+        this->parse_(data, this->now_());
+        return 0;
+      }
+      void transfer(uint8_t *data, size_t len)
+      {
+        for (size_t i = 0; i < len; i++)
+          data[i] = this->transfer(data[i]);
+      }
+
+      // The next count replies to reads of addresses first to last go out with a bad checksum.
+      // Unlike corruption_ppm it hits exactly the replies a test aims at.
+      void corrupt_replies(uint32_t count, uint8_t first = 0x00, uint8_t last = 0xFF)
+      {
+        this->corrupt_count_ = count;
+        this->corrupt_first_ = first;
+        this->corrupt_last_ = last;
+      }
+      // UART: count stray bytes arrive on the reply line, out of step with any frame
+      void inject_noise(uint8_t count)
+      {
+        for (uint8_t i = 0; i < count; i++)
+          this->queue_reply_byte_((uint8_t) this->random_(), this->now_());
+      }
+
+      // Drop unread reply bytes and any half-received frame
+      void discard()
+      {
+        this->reply_count_ = 0;
+        this->state_ = State::IDLE;
+      }
+
+    protected:
+      enum class State : uint8_t
+      {
+        IDLE,
+        READ_ADDRESS,
+        WRITE_ADDRESS,
+        WRITE_DATA,
+      };
+
+      static uint32_t raw_(float value) { return value <= 0 ? 0 : (uint32_t)(value + 0.5f) & 0xFFFFFF; }
+      static uint32_t signed_raw_(float value) { return (uint32_t)(int32_t)(value < 0 ? value - 0.5f : value + 0.5f) & 0xFFFFFF; }
+      // Wrap-safe "a is later than b"
+      static bool after_(uint32_t a, uint32_t b) { return (int32_t)(a - b) > 0; }
+
+      uint32_t now_() const { return this->clock_ != nullptr ? this->clock_() : 0; }
+
+      uint32_t random_()
+      {
+        // xorshift32
+        uint32_t x = this->rng_;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        this->rng_ = x;
+        return x;
+      }
+
+      static bool is_signed_(uint8_t address) { return (address >= BL0910_WATT_1 && address <= BL0910_WATT_SUM) || address == BL0910_TEMPERATURE; }
+      static bool is_noisy_(uint8_t address) { return (address >= BL0910_I_1_RMS && address <= BL0910_V_RMS) || (address >= BL0910_WATT_1 && address <= BL0910_WATT_SUM); }
+
+      static bool is_calibration_(uint8_t address)
+      {
+        return (address >= BL0910_RMSGN_1 && address <= BL0910_RMSOS_10) || (address >= BL0910_WATTGN_1 && address <= BL0910_WATTGN_10);
+      }
+      // Signed value of a calibration register
+      int32_t calibration_(uint8_t address, uint8_t width) const
+      {
+        return (int32_t)(this->registers_[address] << (32 - width)) >> (32 - width);
+      }
+
+      // Measurement registers from the analog state, through the RMS offset and gain and power gain
+      void refresh_measurements_()
+      {
+        this->registers_[BL0910_V_RMS] = raw_(this->voltage_ / BL0910_UREF);
+        float total = 0;
+        for (uint8_t channel = 0; channel < 10; channel++)
+        {
+          float watts = this->voltage_ * this->current_[channel] * this->power_factor_[channel];
+          total += watts;
+          float current = this->current_[channel] / BL0910_IREF;
+          float squared = current * current + 256.0f * this->calibration_(BL0910_RMSOS_1 + channel, 24);
+          float current_gain = 1 + this->calibration_(BL0910_RMSGN_1 + channel, 16) / 65536.0f;
+          float power_gain = 1 + this->calibration_(BL0910_WATTGN_1 + channel, 16) / 65536.0f;
+          this->registers_[BL0910_I_1_RMS + channel] = raw_(std::sqrt(squared > 0 ? squared : 0) * current_gain);
+          this->registers_[BL0910_WATT_1 + channel] = signed_raw_(watts / BL0910_PREF * power_gain);
+        }
+        this->registers_[BL0910_WATT_SUM] = signed_raw_(total / BL0910_WATT);
+      }
+
+      // Integrate channel power into the CF pulse counters up to `now`
+      void accumulate_energy_(uint32_t now)
+      {
+        if (this->clock_ == nullptr)
+          return;
+        if (!this->energy_started_)
+        {
+          this->energy_started_ = true;
+          this->energy_time_ = now;
+          return;
+        }
+        uint32_t elapsed = now - this->energy_time_;
+        this->energy_time_ = now;
+        double hours = elapsed / 3600e6;
+        double total = 0;
+        for (uint8_t channel = 0; channel < 10; channel++)
+        {
+          double kw = this->voltage_ * this->current_[channel] * this->power_factor_[channel] / 1000.0;
+          if (kw < 0)
+            kw = -kw;
+          total += kw;
+          this->pulses_[channel] += kw * hours / BL0910_EREF;
+          this->registers_[BL0910_CF_1_CNT + channel] = (uint32_t)(uint64_t) this->pulses_[channel] & 0xFFFFFF;
+        }
+        this->pulses_sum_ += total * hours / BL0910_CF;
+        this->registers_[BL0910_CF_SUM_CNT] = (uint32_t)(uint64_t) this->pulses_sum_ & 0xFFFFFF;
+      }
+
+      // Instantaneous sample of a waveform register at `now`. Peaks follow the RMS register scale,
+      // with each current lagging the voltage by its power factor angle.
+      uint32_t wave_sample_(uint8_t address, uint32_t now) const
+      {
+        uint8_t wave = address - BL0910_WAVE_1;
+        bool voltage = address == BL0910_WAVE_V;
+        float rms = voltage ? this->voltage_ / BL0910_UREF : this->current_[wave] / BL0910_IREF;
+        double phase = 2 * M_PI * std::fmod(now * 1e-6 * this->frequency_, 1.0);
+        if (!voltage)
+          phase -= std::acos(std::fmax(-1.0f, std::fmin(1.0f, this->power_factor_[wave])));
+        double sample = std::sin(phase);
+        for (uint8_t order = 2; order <= MAX_HARMONIC; order++)
+        {
+          if (this->harmonics_[wave][order] != 0)
+            sample += this->harmonics_[wave][order] * std::sin(order * phase);
+        }
+        return signed_raw_((float) (sample * rms * M_SQRT2));
+      }
+
+      uint32_t read_register_(uint8_t address, uint32_t now)
+      {
+        if (address >= BL0910_WAVE_1 && address <= BL0910_WAVE_V)
+          return this->wave_sample_(address, now);
+        uint32_t value = this->registers_[address];
+        if (this->config_.noise_lsb == 0 || !is_noisy_(address))
+          return value;
+        int32_t noise = (int32_t)(this->random_() % (2 * this->config_.noise_lsb + 1)) - (int32_t) this->config_.noise_lsb;
+        if (is_signed_(address))
+        {
+          int32_t signed_value = (int32_t)(value << 8) >> 8;
+          return (uint32_t)(signed_value + noise) & 0xFFFFFF;
+        }
+        if (noise < 0 && (uint32_t)(-noise) > value)
+          return 0;
+        return (value + noise) & 0xFFFFFF;
+      }
+
+      void queue_reply_byte_(uint8_t data, uint32_t earliest)
+      {
+        if (this->reply_count_ >= REPLY_BUFFER_SIZE)
+        {
+          // Host stopped reading, the oldest byte is overrun
+          this->reply_head_ = (this->reply_head_ + 1) % REPLY_BUFFER_SIZE;
+          this->reply_count_--;
+        }
+        uint32_t corruption_ppm = this->config_.corruption_ppm;
+        if (this->spi_ && this->config_.clean_clock_hz != 0 && this->config_.spi_clock_hz > this->config_.clean_clock_hz)
+        {
+          // Edges smear on long traces: one corrupted byte in 50 at twice the clean clock
+          corruption_ppm += (uint32_t) (20000.0f * (this->config_.spi_clock_hz - this->config_.clean_clock_hz) /
+                                        this->config_.clean_clock_hz);
+        }
+        if (corruption_ppm != 0 && this->random_() % 1000000 < corruption_ppm)
+        {
+          data ^= 1 << (this->random_() % 8);
+          this->stats_.corrupted_bytes++;
+        }
+        // Replies are serialized on the TX line behind any bytes still being sent
+        uint32_t start = after_(this->tx_done_, earliest) && this->reply_count_ > 0 ? this->tx_done_ : earliest;
+        this->tx_done_ = start + this->config_.byte_time_us;
+        size_t tail = (this->reply_head_ + this->reply_count_) % REPLY_BUFFER_SIZE;
+        this->reply_[tail] = data;
+        this->reply_ready_[tail] = this->tx_done_;
+        this->reply_count_++;
+        this->stats_.bytes_out++;
+      }
+
+      // Next recorded read of an address, nullptr if the trace has none
+      const TraceRecord *next_replay_(uint8_t address)
+      {
+        size_t count = this->replay_.size();
+        size_t start = this->replay_cursor_[address];
+        for (size_t i = 0; i < count; i++)
+        {
+          size_t index = (start + i) % count;
+          const TraceRecord &record = this->replay_[index];
+          if (record.address == address && record.kind != TraceKind::WRITE)
+          {
+            this->replay_cursor_[address] = index + 1;
+            return &record;
+          }
+        }
+        return nullptr;
+      }
+
+      void queue_read_reply_(uint8_t address, uint32_t now)
+      {
+        uint8_t h, m, l, checksum;
+        if (this->is_replaying())
+        {
+          const TraceRecord *record = this->next_replay_(address);
+          if (record == nullptr || record->kind == TraceKind::TIMEOUT || record->kind == TraceKind::DROPPED)
+            return;
+          h = record->h;
+          m = record->m;
+          l = record->l;
+          checksum = record->checksum;
+        }
+        else
+        {
+          this->accumulate_energy_(now);
+          uint32_t value = this->read_register_(address, now);
+          h = (value >> 16) & 0xFF;
+          m = (value >> 8) & 0xFF;
+          l = value & 0xFF;
+          checksum = bl0910_frame_checksum(address, l, m, h);
+        }
+        if (this->corrupt_count_ > 0 && address >= this->corrupt_first_ && address <= this->corrupt_last_)
+        {
+          this->corrupt_count_--;
+          checksum ^= 0xFF;
+          this->stats_.corrupted_bytes++;
+        }
+        uint32_t earliest = now + this->config_.reply_latency_us;
+        if (this->spi_)
+        {
+          // SPI shifts MSB first: H, M, L, checksum
+          this->queue_reply_byte_(h, earliest);
+          this->queue_reply_byte_(m, earliest);
+          this->queue_reply_byte_(l, earliest);
+        }
+        else
+        {
+          // UART sends LSB first: L, M, H, checksum
+          this->queue_reply_byte_(l, earliest);
+          this->queue_reply_byte_(m, earliest);
+          this->queue_reply_byte_(h, earliest);
+        }
+        this->queue_reply_byte_(checksum, earliest);
+        this->stats_.read_frames++;
+      }
+
+      void apply_write_()
+      {
+        const uint8_t *d = this->write_data_;
+        // UART carries L, M, H; SPI carries H, M, L
+        uint8_t l = this->spi_ ? d[2] : d[0];
+        uint8_t m = d[1];
+        uint8_t h = this->spi_ ? d[0] : d[2];
+        this->stats_.write_frames++;
+        if (bl0910_frame_checksum(this->write_address_, l, m, h) != d[3])
+        {
+          this->stats_.rejected_writes++;
+          return;
+        }
+        uint32_t value = (uint32_t) h << 16 | (uint32_t) m << 8 | l;
+        if (this->write_address_ == BL0910_USR_WRPROT)
+        {
+          this->write_protected_ = value != 0x5555;
+          this->registers_[BL0910_USR_WRPROT] = value;
+          return;
+        }
+        if (this->write_address_ == BL0910_SOFT_RESET)
+        {
+          if (value == 0x5A5A5A)
+          {
+            EmulatorStats stats = this->stats_;
+            this->load_defaults();
+            this->stats_ = stats;
+          }
+          return;
+        }
+        if (this->write_protected_)
+        {
+          this->stats_.rejected_writes++;
+          return;
+        }
+        this->registers_[this->write_address_] = value;
+        if (is_calibration_(this->write_address_))
+          this->refresh_measurements_();
+      }
+
+      void parse_(uint8_t data, uint32_t now)
+      {
+        uint8_t read_command = this->spi_ ? BL0910_SPI_READ_COMMAND : BL0910_READ_COMMAND;
+        uint8_t write_command = this->spi_ ? BL0910_SPI_WRITE_COMMAND : BL0910_WRITE_COMMAND;
+        switch (this->state_)
+        {
+        case State::IDLE:
+          if (data == read_command)
+            this->state_ = State::READ_ADDRESS;
+          else if (data == write_command)
+            this->state_ = State::WRITE_ADDRESS;
+          else
+            this->stats_.dropped_bytes++;
+          break;
+        case State::READ_ADDRESS:
+          this->queue_read_reply_(data, now);
+          this->state_ = State::IDLE;
+          break;
+        case State::WRITE_ADDRESS:
+          this->write_address_ = data;
+          this->write_index_ = 0;
+          this->state_ = State::WRITE_DATA;
+          break;
+        case State::WRITE_DATA:
+          this->write_data_[this->write_index_++] = data;
+          if (this->write_index_ == sizeof(this->write_data_))
+          {
+            this->apply_write_();
+            this->state_ = State::IDLE;
+          }
+          break;
+        }
+      }
+
+      EmulatorConfig config_{};
+      EmulatorStats stats_{};
+      ClockFunc clock_{nullptr};
+      bool spi_{false};
+      uint32_t rng_{1};
+      // Replies still to corrupt by corrupt_replies(), and the addresses they are limited to
+      uint32_t corrupt_count_{0};
+      uint8_t corrupt_first_{0x00};
+      uint8_t corrupt_last_{0xFF};
+
+      uint32_t registers_[REGISTER_COUNT];
+
+      // Recorded trace being replayed, and where the next read of each address looks from
+      std::vector<TraceRecord> replay_;
+      uint32_t replay_cursor_[REGISTER_COUNT];
+      bool write_protected_{true};
+
+      // Analog front end
+      float voltage_{230.0f};
+      float current_[10];
+      float power_factor_[10];
+      float frequency_{50.0f};
+      // Harmonic amplitudes relative to the fundamental per waveform, indexed by [channel - 1][order]
+      float harmonics_[11][MAX_HARMONIC + 1];
+      double pulses_[10];
+      double pulses_sum_{0};
+      bool energy_started_{false};
+      uint32_t energy_time_{0};
+
+      // Frame parser
+      State state_{State::IDLE};
+      uint8_t write_address_{0};
+      uint8_t write_data_[4];
+      uint8_t write_index_{0};
+      uint8_t ff_run_{0};
+
+      // Reply ring, each byte stamped with the time it has fully arrived at the host
+      uint8_t reply_[REPLY_BUFFER_SIZE];
+      uint32_t reply_ready_[REPLY_BUFFER_SIZE];
+      size_t reply_head_{0};
+      size_t reply_count_{0};
+      uint32_t rx_done_{0};
+      uint32_t tx_done_{0};
+    };
+
+  } // namespace bl0910
+} // namespace esphome
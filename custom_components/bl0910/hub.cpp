@@ -0,0 +1,199 @@
+#include "hub.h"
+#include <cmath>
+#include "esphome/core/log.h"
+#include "esphome/core/hal.h"
+
+namespace esphome
+{
+  namespace bl0910
+  {
+    static const char *const TAG = "bl0910.hub";
+
+    void BL0910Hub::register_chip(BL0910 *chip, uint8_t phase)
+    {
+      chip->hub_ = this;
+      this->chips_.push_back(Chip{chip, phase, nullptr});
+    }
+
+    void BL0910Hub::setup()
+    {
+      this->next_chip_ = this->chips_.size();
+      if (!this->share_line_readings_)
+      {
+        return;
+      }
+      // The first chip of each phase reads voltage and frequency for the others
+      for (size_t i = 0; i < this->chips_.size(); i++)
+      {
+        Chip &chip = this->chips_[i];
+        if (chip.phase == 0)
+        {
+          continue;
+        }
+        for (size_t j = 0; j < i; j++)
+        {
+          if (this->chips_[j].phase == chip.phase)
+          {
+            chip.line_source = this->chips_[j].chip;
+            break;
+          }
+        }
+      }
+    }
+
+    void BL0910Hub::update()
+    {
+      if (this->next_chip_ < this->chips_.size())
+      {
+        // The previous sweep has not finished, let it complete rather than starting over
+        this->skipped_sweeps_++;
+        ESP_LOGW(TAG, "Sweep still running at chip %u, skipping this update", (unsigned) this->next_chip_);
+        return;
+      }
+      this->next_chip_ = 0;
+      this->sweep_start_ = micros();
+    }
+
+    // Sweep chips in registration order, one transaction each, while the loop budget lasts.
+    // Overload watches that are due go first, between chips as well as between sweeps.
+    // Idle tasks (waveform captures, register checks) run between sweeps only, one per call.
+    void BL0910Hub::loop()
+    {
+      uint32_t start = micros();
+      this->watch_chips_();
+      if (this->next_chip_ >= this->chips_.size())
+      {
+        this->run_idle_tasks_();
+        this->loop_time_.add(micros() - start);
+        return;
+      }
+      do
+      {
+        this->sweep_chip_(this->chips_[this->next_chip_++]);
+        this->watch_chips_();
+        if (this->next_chip_ == this->chips_.size())
+        {
+          this->last_sweep_us_ = micros() - this->sweep_start_;
+          if (this->last_sweep_us_ > this->max_sweep_us_)
+          {
+            this->max_sweep_us_ = this->last_sweep_us_;
+          }
+          this->sweep_count_++;
+          if (this->sweep_duration_sensor_ != nullptr)
+          {
+            this->sweep_duration_sensor_->publish_state(this->last_sweep_us_ / 1000.0f);
+          }
+          break;
+        }
+      } while (micros() - start < this->loop_budget_us_);
+      this->loop_time_.add(micros() - start);
+    }
+
+    void BL0910Hub::sweep_chip_(const Chip &chip)
+    {
+      BL0910 *bl0910 = chip.chip;
+      // Commands queued on the chip run while the bus is between its transactions
+      if (!bl0910->commands_.empty())
+      {
+        bl0910->handle_commands_();
+      }
+      bl0910->start_sweep_();
+
+      BL0910 *source = chip.line_source;
+      bool share_voltage = source != nullptr && source->voltage_sensor_ != nullptr;
+      bool share_frequency = source != nullptr && source->frequency_sensor_ != nullptr;
+      size_t count = bl0910->collect_sweep_steps_(this->steps_, MAX_SWEEP_STEPS, share_voltage, share_frequency);
+
+      // Shared readings first, so channel calculations see the same voltage as the source chip
+      if (share_voltage && !std::isnan(source->voltage_))
+      {
+        bl0910->voltage_ = source->voltage_;
+        if (bl0910->voltage_sensor_ != nullptr)
+        {
+          bl0910->publish_(bl0910->voltage_sensor_, source->voltage_, bl0910->gates_[(uint8_t) SensorSlot::VOLTAGE]);
+        }
+      }
+      if (share_frequency && !std::isnan(source->frequency_))
+      {
+        bl0910->frequency_ = source->frequency_;
+        if (bl0910->frequency_sensor_ != nullptr)
+        {
+          bl0910->publish_(bl0910->frequency_sensor_, source->frequency_, bl0910->gates_[(uint8_t) SensorSlot::FREQUENCY]);
+        }
+      }
+      this->read_steps_(bl0910, this->steps_, count);
+      bl0910->end_sweep_();
+    }
+
+    // The current and power reads of every chip whose overload watch is due, one transaction each
+    void BL0910Hub::watch_chips_()
+    {
+      for (const Chip &chip : this->chips_)
+      {
+        BL0910 *bl0910 = chip.chip;
+        if (bl0910->watch_due_())
+        {
+          bl0910->last_watch_ = micros();
+          this->read_steps_(bl0910, bl0910->watch_, bl0910->watch_size_);
+        }
+      }
+    }
+
+    // Queued commands of every chip, then the idle task of the first chip that has one due
+    void BL0910Hub::run_idle_tasks_()
+    {
+      for (const Chip &chip : this->chips_)
+      {
+        if (!chip.chip->commands_.empty())
+        {
+          chip.chip->handle_commands_();
+        }
+      }
+      for (const Chip &chip : this->chips_)
+      {
+        if (chip.chip->run_idle_task_())
+        {
+          return;
+        }
+      }
+    }
+
+    // Read the registers of count steps from a chip as one transaction and process the replies
+    void BL0910Hub::read_steps_(BL0910 *bl0910, const ReadStep *steps, size_t count)
+    {
+      if (count == 0)
+      {
+        return;
+      }
+      uint8_t *frame = this->frames_;
+      for (size_t i = 0; i < count; i++, frame += BL0910_FRAME_SIZE)
+      {
+        memset(frame, 0x00, BL0910_FRAME_SIZE);
+        frame[0] = BL0910_SPI_READ_COMMAND;
+        frame[1] = steps[i].reg->address;
+      }
+      bl0910->transfer_frames_(this->frames_, count);
+      bl0910->process_spi_frames_(this->frames_, steps, count);
+    }
+
+    void BL0910Hub::dump_config()
+    {
+      ESP_LOGCONFIG(TAG, "BL0910 Hub:");
+      ESP_LOGCONFIG(TAG, "  Chips: %u", (unsigned) this->chips_.size());
+      ESP_LOGCONFIG(TAG, "  Share Line Readings: %s", YESNO(this->share_line_readings_));
+      for (size_t i = 0; i < this->chips_.size(); i++)
+      {
+        const Chip &chip = this->chips_[i];
+        ESP_LOGCONFIG(TAG, "  Chip %u: phase %u%s", (unsigned) i, chip.phase,
+                      chip.line_source != nullptr ? ", shared voltage/frequency" : "");
+      }
+      LOG_UPDATE_INTERVAL(this);
+      LOG_SENSOR("  ", "Sweep Duration", this->sweep_duration_sensor_);
+      ESP_LOGCONFIG(TAG, "  Sweeps: %u, last %u us, max %u us, skipped %u", this->sweep_count_, this->last_sweep_us_,
+                    this->max_sweep_us_, this->skipped_sweeps_);
+      ESP_LOGCONFIG(TAG, "  loop(): p50 %u us, p99 %u us, max %u us", this->loop_time_.percentile(0.5f),
+                    this->loop_time_.percentile(0.99f), this->loop_time_.max);
+    }
+
+  } // namespace bl0910
+} // namespace esphome
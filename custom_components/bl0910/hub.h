@@ -0,0 +1,73 @@
+#pragma once
+
+#include <vector>
+#include "esphome/components/sensor/sensor.h"
+#include "esphome/core/component.h"
+#include "bl0910.h"
+
+namespace esphome
+{
+  namespace bl0910
+  {
+    // Most register reads in one chip's sweep
+    static const uint8_t MAX_SWEEP_STEPS = BL0910_MAX_SCHEDULE;
+
+    // Owns several BL0910 chips on one SPI bus and sweeps them in turn. Each chip's whole
+    // sweep goes out as a single transaction, and chips on the same phase can share one
+    // voltage/frequency reading.
+    class BL0910Hub : public PollingComponent
+    {
+      SUB_SENSOR(sweep_duration)
+
+    public:
+      void setup() override;
+      void loop() override;
+      void update() override;
+      void dump_config() override;
+      float get_setup_priority() const override { return setup_priority::DATA; }
+
+      // phase 0 means the chip does not share line readings
+      void register_chip(BL0910 *chip, uint8_t phase);
+      void set_share_line_readings(bool share) { this->share_line_readings_ = share; }
+      void set_loop_budget(uint32_t budget_us) { this->loop_budget_us_ = budget_us; }
+      // Sweep and loop() timings since boot, e.g. for benchmarks
+      uint32_t get_last_sweep_us() const { return this->last_sweep_us_; }
+      uint32_t get_max_sweep_us() const { return this->max_sweep_us_; }
+      uint32_t get_sweep_count() const { return this->sweep_count_; }
+      const DurationHistogram &get_loop_time() const { return this->loop_time_; }
+
+    protected:
+      struct Chip
+      {
+        BL0910 *chip;
+        uint8_t phase;
+        // Chip whose voltage/frequency readings this one uses, nullptr if it reads its own
+        BL0910 *line_source;
+      };
+
+      void sweep_chip_(const Chip &chip);
+      void watch_chips_();
+      void run_idle_tasks_();
+      void read_steps_(BL0910 *bl0910, const ReadStep *steps, size_t count);
+
+      std::vector<Chip> chips_;
+      bool share_line_readings_{false};
+      uint32_t loop_budget_us_{1000};
+
+      // Index of the next chip to sweep, chips_.size() when idle
+      size_t next_chip_{0};
+      uint32_t sweep_start_{0};
+      uint32_t last_sweep_us_{0};
+      uint32_t max_sweep_us_{0};
+      uint32_t sweep_count_{0};
+      // Time each loop() call blocks, the chips have no loop() of their own
+      DurationHistogram loop_time_;
+      uint32_t skipped_sweeps_{0};
+
+      // One chip's sweep at a time, reused for every chip
+      ReadStep steps_[MAX_SWEEP_STEPS];
+      uint8_t frames_[MAX_SWEEP_STEPS * BL0910_FRAME_SIZE];
+    };
+
+  } // namespace bl0910
+} // namespace esphome
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Compact binary frame carrying one sweep's readings. No ESPHome dependencies, so host-side
+// collectors and tools can build and check frames too.
+namespace esphome
+{
+  namespace bl0910
+  {
+    // Wire format, little endian. Collectors should drop frames of a version they do not know.
+    //   0   'B' 'L'    magic
+    //   2   version
+    //   3   chip       set in the configuration, tells the chips of one device apart
+    //   4   sequence   u32, one per frame since boot, a gap is a lost frame
+    //   8   timestamp  u32, millis() at the start of the sweep
+    //   12  count      entries that follow
+    //   13  entries    TELEMETRY_ENTRY_SIZE bytes each:
+    //                  quantity, channel (1-10, 0 chip-wide), raw u24, value f32
+    static const uint8_t TELEMETRY_VERSION = 1;
+    static const size_t TELEMETRY_HEADER_SIZE = 13;
+    static const size_t TELEMETRY_ENTRY_SIZE = 9;
+    // Every register of the table, power factor and apparent power of 10 channels, and the
+    // per-channel voltage reads of snapshot sampling
+    static const uint8_t TELEMETRY_MAX_ENTRIES = 80;
+    static const size_t TELEMETRY_MAX_FRAME_SIZE = TELEMETRY_HEADER_SIZE + TELEMETRY_MAX_ENTRIES * TELEMETRY_ENTRY_SIZE;
+
+    // What an entry holds. Values are in the units of the matching sensors; derived quantities
+    // have no register and carry a raw value of 0.
+    enum class TelemetryQuantity : uint8_t
+    {
+      CURRENT,        // A
+      POWER,          // W
+      ENERGY,         // kWh since the baseline, raw is the pulse counter
+      POWER_FACTOR,   // derived
+      APPARENT_POWER, // VA, derived
+      TEMPERATURE,    // °C
+      FREQUENCY,      // Hz
+      VOLTAGE,        // V
+      TOTAL_POWER,    // W
+      TOTAL_ENERGY,   // kWh
+    };
+
+    // One frame, built entry by entry over a sweep. The buffer is reserved once and reused.
+    class TelemetryFrame
+    {
+    public:
+      void reserve() { this->data_.reserve(TELEMETRY_MAX_FRAME_SIZE); }
+
+      // Start a frame for the sweep starting at timestamp (ms)
+      void begin(uint8_t chip, uint32_t timestamp)
+      {
+        this->data_.resize(TELEMETRY_HEADER_SIZE);
+        uint8_t *header = this->data_.data();
+        header[0] = 'B';
+        header[1] = 'L';
+        header[2] = TELEMETRY_VERSION;
+        header[3] = chip;
+        put_u32(header + 4, 0);
+        put_u32(header + 8, timestamp);
+        header[12] = 0;
+      }
+
+      // Returns false, and drops the entry, once the frame is full
+      bool add(TelemetryQuantity quantity, uint8_t channel, uint32_t raw, float value)
+      {
+        if (this->data_.size() < TELEMETRY_HEADER_SIZE || this->count() >= TELEMETRY_MAX_ENTRIES)
+        {
+          return false;
+        }
+        uint8_t entry[TELEMETRY_ENTRY_SIZE] = {(uint8_t) quantity, channel, (uint8_t) raw, (uint8_t) (raw >> 8),
+                                               (uint8_t) (raw >> 16)};
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        put_u32(entry + 5, bits);
+        this->data_.insert(this->data_.end(), entry, entry + TELEMETRY_ENTRY_SIZE);
+        this->data_[12]++;
+        return true;
+      }
+
+      // Stamp the sequence number, the frame is then complete
+      void finish(uint32_t sequence) { put_u32(this->data_.data() + 4, sequence); }
+
+      uint8_t count() const { return this->data_.size() < TELEMETRY_HEADER_SIZE ? 0 : this->data_[12]; }
+      const std::vector<uint8_t> &data() const { return this->data_; }
+
+      // Whether data holds a whole frame of a version this code reads
+      static bool valid(const uint8_t *data, size_t size)
+      {
+        return size >= TELEMETRY_HEADER_SIZE && data[0] == 'B' && data[1] == 'L' && data[2] == TELEMETRY_VERSION &&
+               size == TELEMETRY_HEADER_SIZE + data[12] * TELEMETRY_ENTRY_SIZE;
+      }
+
+    protected:
+      static void put_u32(uint8_t *out, uint32_t value)
+      {
+        for (uint8_t i = 0; i < 4; i++)
+        {
+          out[i] = (uint8_t) (value >> (8 * i));
+        }
+      }
+
+      std::vector<uint8_t> data_;
+    };
+
+  } // namespace bl0910
+} // namespace esphome
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+// Record of the frames exchanged with the chip, and its text form. No ESPHome dependencies, so
+// the emulator and host-side tools read the same records the component writes.
+namespace esphome
+{
+  namespace bl0910
+  {
+    enum class TraceKind : uint8_t
+    {
+      READ,    // a read and the reply as it arrived, checksum not yet checked
+      TIMEOUT, // a read that got no whole reply
+      WRITE,   // a write and the value sent
+      DROPPED, // a read whose reply was dropped unread while re-framing the stream
+    };
+
+    // One frame. Data bytes are the register value, independent of the bus byte order.
+    struct TraceRecord
+    {
+      uint32_t time_us;
+      TraceKind kind;
+      uint8_t address;
+      uint8_t h;
+      uint8_t m;
+      uint8_t l;
+      uint8_t checksum;
+    };
+
+    // Text form of a record, 20 hex digits: time, kind, address, H M L, checksum
+    static const size_t TRACE_TEXT_SIZE = 20;
+
+    // Writes TRACE_TEXT_SIZE characters and a terminating zero
+    inline void format_trace_record(const TraceRecord &record, char *out)
+    {
+      snprintf(out, TRACE_TEXT_SIZE + 1, "%08X%02X%02X%02X%02X%02X%02X", (unsigned) record.time_us, (unsigned) record.kind,
+               record.address, record.h, record.m, record.l, record.checksum);
+    }
+
+    // Parses the TRACE_TEXT_SIZE characters at text, returns false if they are not a record
+    inline bool parse_trace_record(const char *text, TraceRecord &record)
+    {
+      uint8_t bytes[10];
+      for (size_t i = 0; i < TRACE_TEXT_SIZE; i++)
+      {
+        char c = text[i];
+        uint8_t nibble;
+        if (c >= '0' && c <= '9')
+          nibble = c - '0';
+        else if (c >= 'A' && c <= 'F')
+          nibble = c - 'A' + 10;
+        else if (c >= 'a' && c <= 'f')
+          nibble = c - 'a' + 10;
+        else
+          return false;
+        bytes[i / 2] = (i % 2 == 0) ? nibble << 4 : bytes[i / 2] | nibble;
+      }
+      if (bytes[4] > (uint8_t) TraceKind::DROPPED)
+        return false;
+      record.time_us = (uint32_t) bytes[0] << 24 | (uint32_t) bytes[1] << 16 | (uint32_t) bytes[2] << 8 | bytes[3];
+      record.kind = (TraceKind) bytes[4];
+      record.address = bytes[5];
+      record.h = bytes[6];
+      record.m = bytes[7];
+      record.l = bytes[8];
+      record.checksum = bytes[9];
+      return true;
+    }
+
+    // Ring of the latest records over storage handed in once by the owner, never reallocated
+    class TraceRing
+    {
+    public:
+      void attach(TraceRecord *storage, uint16_t capacity)
+      {
+        this->storage_ = storage;
+        this->capacity_ = capacity;
+        this->clear();
+      }
+      void clear()
+      {
+        this->head_ = 0;
+        this->size_ = 0;
+        this->overwritten_ = 0;
+      }
+      // Append a record, overwriting the oldest once full
+      void push(const TraceRecord &record)
+      {
+        uint16_t tail = this->head_ + this->size_;
+        if (tail >= this->capacity_)
+          tail -= this->capacity_;
+        this->storage_[tail] = record;
+        if (this->size_ < this->capacity_)
+          this->size_++;
+        else
+        {
+          this->overwritten_++;
+          if (++this->head_ == this->capacity_)
+            this->head_ = 0;
+        }
+      }
+      uint16_t size() const { return this->size_; }
+      uint16_t capacity() const { return this->capacity_; }
+      // Records lost to newer ones since the last clear()
+      uint32_t overwritten() const { return this->overwritten_; }
+      // i-th oldest record
+      const TraceRecord &at(uint16_t i) const
+      {
+        uint16_t index = this->head_ + i;
+        return this->storage_[index >= this->capacity_ ? index - this->capacity_ : index];
+      }
+
+    protected:
+      TraceRecord *storage_{nullptr};
+      uint16_t capacity_{0};
+      uint16_t head_{0};
+      uint16_t size_{0};
+      uint32_t overwritten_{0};
+    };
+
+  } // namespace bl0910
+} // namespace esphome
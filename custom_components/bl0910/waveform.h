@@ -0,0 +1,213 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// Waveform sample buffer and harmonic analysis. No ESPHome dependencies, so host-side tools
+// can run the analysis on synthetic waveforms.
+namespace esphome
+{
+  namespace bl0910
+  {
+    // Highest harmonic order analysed, the fundamental is order 1
+    static const uint8_t WAVEFORM_MAX_HARMONIC = 15;
+
+    // Ring of waveform samples over storage handed in once by the owner, never reallocated
+    class WaveformRing
+    {
+    public:
+      void attach(int32_t *storage, uint16_t capacity)
+      {
+        this->storage_ = storage;
+        this->capacity_ = capacity;
+        this->clear();
+      }
+      void clear()
+      {
+        this->head_ = 0;
+        this->size_ = 0;
+      }
+      // Append a sample, overwriting the oldest once full
+      void push(int32_t sample)
+      {
+        uint16_t tail = this->head_ + this->size_;
+        if (tail >= this->capacity_)
+          tail -= this->capacity_;
+        this->storage_[tail] = sample;
+        if (this->size_ < this->capacity_)
+          this->size_++;
+        else if (++this->head_ == this->capacity_)
+          this->head_ = 0;
+      }
+      uint16_t size() const { return this->size_; }
+      uint16_t capacity() const { return this->capacity_; }
+      bool full() const { return this->size_ == this->capacity_; }
+      // i-th oldest sample
+      int32_t at(uint16_t i) const
+      {
+        uint16_t index = this->head_ + i;
+        return this->storage_[index >= this->capacity_ ? index - this->capacity_ : index];
+      }
+
+    protected:
+      int32_t *storage_{nullptr};
+      uint16_t capacity_{0};
+      uint16_t head_{0};
+      uint16_t size_{0};
+    };
+
+    // Harmonic content averaged over the captures added
+    struct HarmonicResult
+    {
+      // Highest order analysed, 0 if nothing could be analysed
+      uint8_t count{0};
+      // Amplitude per order in sample units, [1] is the fundamental, [0] unused
+      float magnitude[WAVEFORM_MAX_HARMONIC + 1]{};
+      // Total harmonic distortion over orders 2..count, as a fraction of the fundamental
+      float thd{NAN};
+
+      // Order n relative to the fundamental, NaN if it was not analysed
+      float relative(uint8_t order) const
+      {
+        if (order > this->count || !(this->magnitude[1] > 0))
+          return NAN;
+        return this->magnitude[order] / this->magnitude[1];
+      }
+    };
+
+    // Goertzel filters at the fundamental and its harmonics, run in 64-bit fixed point. Each
+    // capture is trimmed to a whole number of fundamental cycles, so every harmonic sits exactly on
+    // an analysis bin and a rectangular window leaks nothing between them. Harmonic powers are
+    // averaged over the captures added since reset().
+    class HarmonicAnalyzer
+    {
+    public:
+      // Fraction of the sample rate above which harmonics are not analysed (aliasing)
+      static constexpr float NYQUIST_MARGIN = 0.45f;
+      // Filter coefficients are 2cos(w) in Q30
+      static const int COEFF_BITS = 30;
+
+      void reset()
+      {
+        for (uint8_t order = 0; order <= WAVEFORM_MAX_HARMONIC; order++)
+          this->power_[order] = 0;
+        this->count_ = 0;
+        this->captures_ = 0;
+      }
+
+      // Analyse one contiguous capture. Returns false if it is shorter than one fundamental
+      // cycle, or the sample rate leaves no room for the fundamental.
+      bool add(const WaveformRing &ring, float sample_rate, float fundamental, uint8_t max_order)
+      {
+        if (!(sample_rate > 0) || !(fundamental > 0))
+          return false;
+        uint16_t cycles = (uint16_t) (ring.size() * fundamental / sample_rate);
+        if (cycles == 0)
+          return false;
+        uint16_t used = (uint16_t) std::lround(cycles * sample_rate / fundamental);
+        if (used > ring.size())
+          used = ring.size();
+        if (max_order > WAVEFORM_MAX_HARMONIC)
+          max_order = WAVEFORM_MAX_HARMONIC;
+        uint8_t count = 0;
+        while (count < max_order && (count + 1) * fundamental < NYQUIST_MARGIN * sample_rate)
+          count++;
+        if (count == 0)
+          return false;
+
+        // Remove the DC offset, it only eats headroom
+        int64_t sum = 0;
+        for (uint16_t i = 0; i < used; i++)
+          sum += ring.at(i);
+        int32_t mean = (int32_t) (sum / used);
+        uint32_t peak = 1;
+        for (uint16_t i = 0; i < used; i++)
+        {
+          int32_t sample = ring.at(i) - mean;
+          uint32_t magnitude = sample < 0 ? -(uint32_t) sample : sample;
+          if (magnitude > peak)
+            peak = magnitude;
+        }
+
+        // A filter state is bounded by used * peak / sin(w). Scale the samples down (block floating
+        // point) so that bound stays within 31 bits and coeff * state fits in 64.
+        const float two_pi = 6.283185307f;
+        float w_low = two_pi * fundamental / sample_rate;
+        float w_high = w_low * count;
+        float sin_min = std::fmin(std::sin(w_low), std::sin(w_high));
+        int growth_bits = (int) std::ceil(std::log2(used / sin_min));
+        int sample_bits = 31 - growth_bits;
+        if (sample_bits < 1)
+          return false;
+        int shift = bit_length_(peak) - sample_bits;
+        if (shift < 0)
+          shift = 0;
+
+        for (uint8_t order = 1; order <= count; order++)
+        {
+          float w = w_low * order;
+          int64_t coeff = std::llround(2.0 * std::cos((double) w) * (1LL << COEFF_BITS));
+          int64_t s1 = 0;
+          int64_t s2 = 0;
+          for (uint16_t i = 0; i < used; i++)
+          {
+            int64_t s0 = ((ring.at(i) - mean) >> shift) + ((coeff * s1) >> COEFF_BITS) - s2;
+            s2 = s1;
+            s1 = s0;
+          }
+          // |X|^2 = s1^2 + s2^2 - 2cos(w) s1 s2, and a sinusoid of amplitude A gives |X| = A * used / 2
+          double d1 = (double) s1;
+          double d2 = (double) s2;
+          double power = d1 * d1 + d2 * d2 - (double) coeff / (1LL << COEFF_BITS) * d1 * d2;
+          double scale = std::ldexp(2.0 / used, shift);
+          this->power_[order] += (power < 0 ? 0 : power) * scale * scale;
+        }
+        // Orders above the smallest capture's count are dropped, so every order left is averaged
+        // over all the captures
+        if (this->captures_ == 0 || count < this->count_)
+          this->count_ = count;
+        this->captures_++;
+        return true;
+      }
+
+      HarmonicResult result() const
+      {
+        HarmonicResult result;
+        if (this->captures_ == 0)
+          return result;
+        result.count = this->count_;
+        double distortion = 0;
+        for (uint8_t order = 1; order <= this->count_; order++)
+        {
+          double power = this->power_[order] / this->captures_;
+          result.magnitude[order] = (float) std::sqrt(power);
+          if (order >= 2)
+            distortion += power;
+        }
+        if (result.magnitude[1] > 0)
+          result.thd = (float) (std::sqrt(distortion) / result.magnitude[1]);
+        return result;
+      }
+      uint16_t captures() const { return this->captures_; }
+
+    protected:
+      static int bit_length_(uint32_t value)
+      {
+        int bits = 0;
+        while (value != 0)
+        {
+          bits++;
+          value >>= 1;
+        }
+        return bits;
+      }
+
+      // Sum of squared amplitudes per order over the captures
+      double power_[WAVEFORM_MAX_HARMONIC + 1]{};
+      uint8_t count_{0};
+      uint16_t captures_{0};
+    };
+
+  } // namespace bl0910
+} // namespace esphome
@@ -0,0 +1,152 @@
+// Lock-free command ring: full and empty, order, drops, wrap-around of the 32-bit sequence
+// counters, and producers on other threads racing the consumer.
+#include <atomic>
+#include <thread>
+
+#include "command_ring.h"
+#include "test.h"
+
+using namespace esphome;
+using namespace esphome::bl0910;
+
+namespace
+{
+  const uint8_t CAPACITY = 8;
+
+  // A ring whose counters start at any position, to reach their wrap without 2^32 commands
+  struct OffsetRing : CommandRing<uint32_t, CAPACITY>
+  {
+    explicit OffsetRing(uint32_t position)
+    {
+      for (uint32_t i = 0; i < CAPACITY; i++)
+        this->slots_[(position + i) % CAPACITY].sequence.store(position + i, std::memory_order_relaxed);
+      this->tail_.store(position, std::memory_order_relaxed);
+      this->head_ = position;
+    }
+  };
+
+  void full_and_empty(CommandRing<uint32_t, CAPACITY> &ring, uint32_t first)
+  {
+    uint32_t value;
+    CHECK(ring.empty());
+    CHECK(!ring.pop(value));
+    for (uint32_t i = 0; i < CAPACITY; i++)
+      CHECK(ring.push(first + i));
+    CHECK(!ring.empty());
+    // Full: new commands are dropped and counted, the queued ones are kept
+    CHECK(!ring.push(1000));
+    CHECK(!ring.push(1001));
+    CHECK(ring.take_dropped() == 2);
+    CHECK(ring.take_dropped() == 0);
+    for (uint32_t i = 0; i < CAPACITY; i++)
+    {
+      CHECK(ring.pop(value));
+      CHECK(value == first + i);
+    }
+    CHECK(ring.empty());
+    CHECK(!ring.pop(value));
+  }
+
+  void single_thread()
+  {
+    CommandRing<uint32_t, CAPACITY> ring;
+    full_and_empty(ring, 0);
+    full_and_empty(ring, 100);
+    // Interleaved, the ring keeps going round
+    uint32_t value;
+    for (uint32_t i = 0; i < 10 * CAPACITY; i++)
+    {
+      CHECK(ring.push(i));
+      CHECK(ring.push(i + 1000));
+      CHECK(ring.pop(value) && value == i);
+      CHECK(ring.pop(value) && value == i + 1000);
+    }
+    CHECK(ring.empty());
+  }
+
+  // Positions run through 2^32 and back to 0 while commands are queued across it
+  void counter_wrap()
+  {
+    OffsetRing ring(0xFFFFFFFF - CAPACITY - 3);
+    full_and_empty(ring, 0);
+    // Three commands queued at a time while the positions go round several times
+    uint32_t value;
+    for (uint32_t i = 0; i < 4 * CAPACITY; i++)
+    {
+      CHECK(ring.push(i));
+      if (i >= 2)
+      {
+        CHECK(ring.pop(value) && value == i - 2);
+      }
+    }
+    CHECK(ring.pop(value) && value == 4 * CAPACITY - 2);
+    CHECK(ring.pop(value) && value == 4 * CAPACITY - 1);
+    full_and_empty(ring, 0);
+  }
+
+  // Two producers push numbered commands while the consumer drains the ring, trying again after a
+  // yield when it is full. Every command comes out exactly once and in order per producer, and
+  // every failed push is counted as dropped.
+  void stress()
+  {
+    const uint32_t PER_PRODUCER = 100000;
+    OffsetRing ring(0xFFFFFFFF - 50000);
+    std::atomic<uint32_t> failed{0};
+    std::atomic<bool> go{false};
+    auto produce = [&](uint32_t producer) {
+      while (!go.load())
+        std::this_thread::yield();
+      for (uint32_t i = 0; i < PER_PRODUCER; i++)
+      {
+        while (!ring.push(producer << 24 | i))
+        {
+          failed++;
+          std::this_thread::yield();
+        }
+      }
+    };
+    std::thread first(produce, 0);
+    std::thread second(produce, 1);
+    go.store(true);
+
+    uint32_t received[2] = {0, 0};
+    bool ordered = true;
+    uint32_t dropped = 0;
+    uint32_t value;
+    while (received[0] + received[1] < 2 * PER_PRODUCER)
+    {
+      if (!ring.pop(value))
+      {
+        std::this_thread::yield();
+        continue;
+      }
+      uint32_t producer = value >> 24;
+      if (producer > 1)
+      {
+        ordered = false;
+        break;
+      }
+      // Each producer's commands come out in the order it pushed them, none twice or missing
+      ordered &= (value & 0xFFFFFF) == received[producer];
+      received[producer]++;
+      dropped += ring.take_dropped();
+    }
+    first.join();
+    second.join();
+    dropped += ring.take_dropped();
+
+    CHECK(ordered);
+    CHECK(received[0] == PER_PRODUCER);
+    CHECK(received[1] == PER_PRODUCER);
+    CHECK(dropped == failed.load());
+    CHECK(ring.empty());
+  }
+} // namespace
+
+int main()
+{
+  single_thread();
+  counter_wrap();
+  stress();
+  return test_result();
+}
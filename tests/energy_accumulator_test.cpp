@@ -0,0 +1,156 @@
+// Energy from the CF pulse counters: exact and monotonic across 24-bit counter wraps, a chip
+// that restarts counting, reset_energy and a reboot with restore_energy. The emulated loads are
+// off, so the counters only move when the test sets them.
+#include "bl0910.h"
+#include "test.h"
+
+using namespace esphome;
+using namespace esphome::bl0910;
+
+namespace
+{
+  const uint32_t COUNTER_MASK = 0xFFFFFF;
+
+  struct Meter
+  {
+    BL0910EmulatedSPI chip;
+    sensor::Sensor energy;
+    sensor::Sensor total_energy;
+    // Pulses the meter should have accumulated, and the last energy published
+    uint64_t pulses{0};
+    float last{0};
+
+    explicit Meter(const char *restore_key)
+    {
+      EmulatorConfig config{};
+      this->chip.set_emulator_config(config);
+      this->chip.set_restore_energy(restore_key != nullptr);
+      if (restore_key != nullptr)
+      {
+        this->chip.set_energy_preference_key(restore_key);
+        this->chip.set_energy_save_threshold(0);
+      }
+      this->chip.set_channel_sensor(1, ChannelSlot::ENERGY, &this->energy);
+      this->chip.set_total_energy_sensor(&this->total_energy);
+      this->chip.setup();
+      for (uint8_t channel = 1; channel <= BL0910_CHANNEL_COUNT; channel++)
+      {
+        this->chip.get_emulator().set_channel_load(channel, 0, 1.0f);
+      }
+    }
+
+    // Set both counters, sweep, and check the energy against the pulses expected
+    void sweep_to(uint32_t count, uint64_t expected_pulses)
+    {
+      BL0910Emulator &emulator = this->chip.get_emulator();
+      emulator.set_register(BL0910_CF_1_CNT, count);
+      emulator.set_register(BL0910_CF_SUM_CNT, count);
+      CHECK(run_sweep(this->chip));
+      this->pulses = expected_pulses;
+      this->check();
+      // Monotonic between resets
+      CHECK(this->energy.state >= this->last);
+      this->last = this->energy.state;
+    }
+
+    // Published exactly as the pulses times the scale of their counter
+    void check()
+    {
+      float expected = (float) (this->pulses * (double) BL0910_EREF);
+      if (this->energy.state != expected)
+      {
+        printf("energy %.9g kWh, expected %.9g (%llu pulses)\n", this->energy.state, expected,
+               (unsigned long long) this->pulses);
+        CHECK(this->energy.state == expected);
+      }
+      CHECK(this->total_energy.state == (float) (this->pulses * (double) BL0910_CF));
+    }
+  };
+
+  // Wraps of the 24-bit counter keep counting up, well past 32 bits of pulses
+  void wraps()
+  {
+    Meter meter(nullptr);
+    // Each step below half the counter's range, a larger one is taken for a restarted chip
+    meter.sweep_to(100, 100);
+    meter.sweep_to(0x600000, 0x600000);
+    meter.sweep_to(0xC00000, 0xC00000);
+    meter.sweep_to(0xFFFFF0, 0xFFFFF0);
+    // 0xFFFFF0 -> 0x10 is 0x20 pulses, not a step back
+    meter.sweep_to(0x10, 0x1000010);
+    // Steps just under half the counter's range, 600 of them run past 2^32 pulses
+    uint32_t count = 0x10;
+    uint64_t pulses = 0x1000010;
+    const uint32_t step = COUNTER_MASK / 2;
+    for (int sweep = 0; sweep < 600; sweep++)
+    {
+      count = (count + step) & COUNTER_MASK;
+      pulses += step;
+      meter.sweep_to(count, pulses);
+    }
+    CHECK(pulses > (1ULL << 32));
+    // An unchanged counter adds nothing
+    meter.sweep_to(count, pulses);
+  }
+
+  // A step back of more than half the range is the chip counting from zero again, not a wrap
+  void chip_restart()
+  {
+    Meter meter(nullptr);
+    meter.sweep_to(0x800000, 0x800000);
+    meter.sweep_to(0x100, 0x800000 + 0x100);
+    meter.sweep_to(0x300, 0x800000 + 0x300);
+  }
+
+  // reset_energy zeroes the energy, and the counter's next read is its new baseline
+  void reset()
+  {
+    Meter meter(nullptr);
+    meter.sweep_to(5000, 5000);
+    meter.chip.enqueue_command(Command{CommandType::RESET_ENERGY});
+    meter.last = 0;
+    meter.sweep_to(5000, 0);
+    meter.sweep_to(5300, 300);
+    // Wrapping after the reset
+    meter.sweep_to(0x700000, 0x700000 - 5000);
+    meter.sweep_to(0xD00000, 0xD00000 - 5000);
+    meter.sweep_to(0xFFFFF0, 0xFFFFF0 - 5000);
+    meter.sweep_to(0x20, 0x1000020 - 5000);
+  }
+
+  // With restore_energy, a reboot carries on from the saved energy: the counter is taken from
+  // where it was saved, or from zero if the chip lost power too
+  void restore()
+  {
+    uint64_t saved;
+    {
+      Meter meter("restore_test");
+      meter.sweep_to(0xFFFF00, 0xFFFF00);
+      meter.sweep_to(0x80, 0x1000080);
+      // The save happens at the start of the next sweep
+      meter.sweep_to(0x80, 0x1000080);
+      saved = meter.pulses;
+    }
+    {
+      // Only the ESP rebooted, the chip kept counting
+      Meter meter("restore_test");
+      meter.sweep_to(0x180, saved + 0x100);
+      meter.sweep_to(0x180, saved + 0x100);
+      saved = meter.pulses;
+    }
+    {
+      // The chip lost power as well and counts from zero
+      Meter meter("restore_test");
+      meter.sweep_to(0x40, saved + 0x40);
+    }
+  }
+} // namespace
+
+int main()
+{
+  wraps();
+  chip_restart();
+  reset();
+  restore();
+  return test_result();
+}
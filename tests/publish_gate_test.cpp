@@ -0,0 +1,118 @@
+// Publish policy of a sensor: deadbands, minimum and maximum publish intervals, and changes to and
+// from unknown.
+#include "bl0910.h"
+#include "test.h"
+
+using namespace esphome;
+using namespace esphome::bl0910;
+
+namespace
+{
+  PublishGate gate(float deadband, float deadband_ratio, uint32_t min_interval_ms = 0, uint32_t max_interval_ms = 0)
+  {
+    PublishGate gate;
+    gate.policy = PublishPolicy{deadband, deadband_ratio, min_interval_ms, max_interval_ms};
+    return gate;
+  }
+
+  void absolute_deadband()
+  {
+    PublishGate g = gate(1.0f, 0);
+    CHECK(g.admit(10.0f, 0));
+    CHECK(!g.admit(10.5f, 1000));
+    CHECK(!g.admit(9.1f, 2000));
+    // A move of exactly the deadband counts
+    CHECK(g.admit(11.0f, 3000));
+    // Measured from the last published value, not the last reading
+    CHECK(!g.admit(10.2f, 4000));
+    CHECK(g.admit(9.9f, 5000));
+    CHECK(g.last_value == 9.9f);
+  }
+
+  void relative_deadband()
+  {
+    PublishGate g = gate(0, 0.1f);
+    CHECK(g.admit(100.0f, 0));
+    CHECK(!g.admit(105.0f, 1000));
+    CHECK(g.admit(111.0f, 2000));
+    // The band follows the last published value: 10% of 111
+    CHECK(!g.admit(101.0f, 3000));
+    // Around zero the band is zero wide: any change publishes, an unchanged value does not
+    CHECK(g.admit(0, 4000));
+    CHECK(!g.admit(0, 5000));
+    CHECK(!g.admit(0, 6000));
+    CHECK(g.admit(0.001f, 7000));
+
+    // The larger of the two bands applies
+    PublishGate both = gate(2.0f, 0.01f);
+    CHECK(both.admit(100.0f, 0));
+    CHECK(!both.admit(101.5f, 1000));
+    CHECK(both.admit(102.0f, 2000));
+    CHECK(both.admit(1000.0f, 3000));
+    CHECK(!both.admit(1005.0f, 4000));
+    CHECK(both.admit(1010.0f, 5000));
+  }
+
+  void intervals()
+  {
+    // Heartbeat: an unchanged value goes out once max_interval has passed since the last publish
+    PublishGate heartbeat = gate(1.0f, 0, 0, 60000);
+    CHECK(heartbeat.admit(5.0f, 0));
+    CHECK(!heartbeat.admit(5.0f, 30000));
+    CHECK(!heartbeat.admit(5.0f, 59999));
+    CHECK(heartbeat.admit(5.0f, 60000));
+    CHECK(!heartbeat.admit(5.0f, 100000));
+    // A change restarts the interval
+    CHECK(heartbeat.admit(7.0f, 110000));
+    CHECK(!heartbeat.admit(7.0f, 169999));
+    CHECK(heartbeat.admit(7.0f, 170000));
+
+    // Rate limit: nothing within min_interval of the last publish, however large the change
+    PublishGate limited = gate(0, 0, 10000, 0);
+    CHECK(limited.admit(1.0f, 0));
+    CHECK(!limited.admit(100.0f, 9999));
+    CHECK(limited.admit(100.0f, 10000));
+    // Without a deadband every reading counts as a change
+    CHECK(limited.admit(100.0f, 20000));
+
+    // Elapsed time across the millis() wrap
+    PublishGate wrapping = gate(1.0f, 0, 1000, 5000);
+    CHECK(wrapping.admit(1.0f, 0xFFFFF000));
+    CHECK(!wrapping.admit(9.0f, 0xFFFFF000 + 999));
+    CHECK(wrapping.admit(9.0f, 0x00000100));
+    CHECK(!wrapping.admit(9.0f, 0x00000100 + 4999));
+    CHECK(wrapping.admit(9.0f, 0x00000100 + 5000));
+  }
+
+  void unknown()
+  {
+    PublishGate g = gate(1.0f, 0.1f, 0, 60000);
+    // The first reading goes out even if it is unknown
+    CHECK(g.admit(NAN, 0));
+    CHECK(!g.admit(NAN, 1000));
+    CHECK(g.admit(230.0f, 2000));
+    CHECK(!g.admit(230.5f, 3000));
+    // To and from unknown is always a change
+    CHECK(g.admit(NAN, 4000));
+    CHECK(std::isnan(g.last_value));
+    CHECK(!g.admit(NAN, 5000));
+    // Unknown still gets its heartbeat
+    CHECK(g.admit(NAN, 64000));
+    CHECK(g.admit(230.5f, 65000));
+
+    // The minimum interval holds back a change to unknown too
+    PublishGate limited = gate(1.0f, 0, 10000, 0);
+    CHECK(limited.admit(1.0f, 0));
+    CHECK(!limited.admit(NAN, 5000));
+    CHECK(limited.admit(NAN, 10000));
+  }
+} // namespace
+
+int main()
+{
+  absolute_deadband();
+  relative_deadband();
+  intervals();
+  unknown();
+  return test_result();
+}
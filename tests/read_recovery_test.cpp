@@ -0,0 +1,208 @@
+// Recovery from bad replies: retries within the sweep's budget, re-framing a UART stream after
+// stray bytes, sitting out sweeps while the chip gives no valid reply, and overload watch reads
+// that fail without giving up the sweep.
+#include <cstring>
+
+#include "bl0910.h"
+#include "test.h"
+
+using namespace esphome;
+using namespace esphome::bl0910;
+
+namespace
+{
+  // 8N1 at 19200 baud
+  const uint32_t UART_BYTE_TIME_US = 520;
+
+  struct Meter
+  {
+    sensor::Sensor voltage;
+    sensor::Sensor frequency;
+    sensor::Sensor current[3];
+    sensor::Sensor power[3];
+
+    template <typename Chip> void attach(Chip &chip, uint32_t byte_time_us)
+    {
+      EmulatorConfig config{};
+      config.byte_time_us = byte_time_us;
+      chip.set_emulator_config(config);
+      chip.set_restore_energy(false);
+      chip.set_voltage_sensor(&this->voltage);
+      chip.set_frequency_sensor(&this->frequency);
+      for (uint8_t channel = 1; channel <= 3; channel++)
+      {
+        chip.set_channel_sensor(channel, ChannelSlot::CURRENT, &this->current[channel - 1]);
+        chip.set_channel_sensor(channel, ChannelSlot::POWER, &this->power[channel - 1]);
+      }
+      chip.setup();
+    }
+
+    int publishes() const
+    {
+      int count = this->voltage.publish_count + this->frequency.publish_count;
+      for (uint8_t i = 0; i < 3; i++)
+      {
+        count += this->current[i].publish_count + this->power[i].publish_count;
+      }
+      return count;
+    }
+
+    // Every reading of the emulator's defaults: 230 V, 50 Hz, channel n at n * 0.5 A and PF 0.9
+    void check_readings() const
+    {
+      CHECK_NEAR(this->voltage.state, 230.0f, 0.1f);
+      CHECK_NEAR(this->frequency.state, 50.0f, 0.05f);
+      for (uint8_t i = 0; i < 3; i++)
+      {
+        CHECK_NEAR(this->current[i].state, (i + 1) * 0.5f, 0.01f);
+        CHECK_NEAR(this->power[i].state, 230.0f * (i + 1) * 0.5f * 0.9f, 1.0f);
+      }
+    }
+  };
+  const int READINGS = 8;
+
+  // One read at a time: each bad reply is read again once, and the sweep completes
+  void retries_within_budget()
+  {
+    BL0910EmulatedUART chip;
+    Meter meter;
+    chip.set_pipeline_depth(1);
+    chip.set_retry_budget(4);
+    meter.attach(chip, UART_BYTE_TIME_US);
+    CHECK(run_sweep(chip));
+    CHECK(chip.get_diagnostics().checksum_errors == 0);
+
+    chip.get_emulator().corrupt_replies(3);
+    CHECK(run_sweep(chip));
+    const BusDiagnostics &diagnostics = chip.get_diagnostics();
+    CHECK(diagnostics.checksum_errors == 3);
+    CHECK(diagnostics.retries == 3);
+    CHECK(diagnostics.discarded_reads == 0);
+    CHECK(meter.publishes() == 2 * READINGS);
+    meter.check_readings();
+
+    // More bad replies than the budget: the reads past it are lost for this sweep only
+    chip.get_emulator().corrupt_replies(6);
+    CHECK(run_sweep(chip));
+    CHECK(diagnostics.retries == 3 + 4);
+    CHECK(meter.publishes() == 3 * READINGS - 2);
+    CHECK(run_sweep(chip));
+    CHECK(meter.publishes() == 4 * READINGS - 2);
+    meter.check_readings();
+  }
+
+  // Stray bytes in a pipelined UART stream: the stream is re-framed and the reads go again
+  void resync_after_garbage()
+  {
+    BL0910EmulatedUART chip;
+    Meter meter;
+    chip.set_pipeline_depth(4);
+    chip.set_retry_budget(8);
+    meter.attach(chip, UART_BYTE_TIME_US);
+    CHECK(run_sweep(chip));
+
+    // The first reads are on their way, the noise lands in the middle of their replies
+    uint32_t sweeps = chip.get_diagnostics().sweeps;
+    chip.update();
+    chip.loop();
+    chip.get_emulator().inject_noise(3);
+    run_loop(chip, 200000);
+    const BusDiagnostics &diagnostics = chip.get_diagnostics();
+    CHECK(diagnostics.sweeps == sweeps + 1);
+    CHECK(diagnostics.checksum_errors + diagnostics.timeouts > 0);
+    CHECK(diagnostics.retries > 0);
+    CHECK(meter.publishes() == 2 * READINGS);
+    meter.check_readings();
+
+    // In step again: the next sweep is clean
+    uint32_t errors = diagnostics.checksum_errors + diagnostics.timeouts;
+    CHECK(run_sweep(chip));
+    CHECK(diagnostics.checksum_errors + diagnostics.timeouts == errors);
+    CHECK(meter.publishes() == 3 * READINGS);
+  }
+
+  // A chip that answers with garbage gives up the sweep after three failed reads in a row, then
+  // sits out 1, 2, 4... sweeps, and is read every sweep again once it answers
+  void backoff_while_silent()
+  {
+    BL0910EmulatedUART chip;
+    Meter meter;
+    chip.set_pipeline_depth(1);
+    chip.set_retry_budget(2);
+    meter.attach(chip, 0);
+    CHECK(run_sweep(chip));
+    int publishes = meter.publishes();
+
+    BL0910Emulator &emulator = chip.get_emulator();
+    emulator.corrupt_replies(1000000);
+    // Read (R) or sat out (-) per sweep
+    char pattern[16] = {};
+    for (int sweep = 0; sweep < 12; sweep++)
+    {
+      uint32_t frames = emulator.get_stats().read_frames;
+      CHECK(run_sweep(chip));
+      pattern[sweep] = emulator.get_stats().read_frames != frames ? 'R' : '-';
+      if (sweep == 0)
+      {
+        // Two retries, then three failures in a row give up the rest of the sweep
+        CHECK(emulator.get_stats().read_frames - frames == 2 + 3);
+      }
+    }
+    CHECK(strcmp(pattern, "R-R--R----R-") == 0);
+    CHECK(meter.publishes() == publishes);
+
+    // Answering again: the next probe reads the whole sweep, and so does every sweep after it
+    emulator.corrupt_replies(0);
+    for (int sweep = 0; sweep < 8; sweep++)
+    {
+      uint32_t frames = emulator.get_stats().read_frames;
+      CHECK(run_sweep(chip));
+      pattern[sweep] = emulator.get_stats().read_frames != frames ? 'R' : '-';
+    }
+    pattern[8] = '\0';
+    // Sat out the rest of the 8 sweeps of the last back-off
+    CHECK(strcmp(pattern, "-------R") == 0);
+    CHECK(run_sweep(chip));
+    CHECK(run_sweep(chip));
+    CHECK(meter.publishes() >= publishes + 3 * READINGS);
+    meter.check_readings();
+  }
+
+  // Watch reads that fail are counted apart from the sweep's reads and never give it up
+  void failed_watch_reads_keep_the_sweep()
+  {
+    BL0910EmulatedSPI chip;
+    Meter meter;
+    // Channels 4-10 are only watched, so the corrupted replies hit nothing but watch reads. A pass
+    // is due at the start of a sweep and not again before it ends.
+    chip.set_watch_interval(5000);
+    for (uint8_t channel = 4; channel <= BL0910_CHANNEL_COUNT; channel++)
+    {
+      chip.set_overload_limit(channel, ChannelSlot::CURRENT, 16.0f, 1.0f);
+    }
+    meter.attach(chip, 0);
+    CHECK(run_sweep(chip));
+    int publishes = meter.publishes();
+    uint32_t start = micros();
+    while (micros() - start < 6000)
+    {
+    }
+
+    chip.get_emulator().corrupt_replies(1000000, BL0910_I_4_RMS, BL0910_I_10_RMS);
+    CHECK(run_sweep(chip));
+    const BusDiagnostics &diagnostics = chip.get_diagnostics();
+    CHECK(diagnostics.watch_failures == 7);
+    CHECK(diagnostics.retries == 0);
+    CHECK(meter.publishes() == publishes + READINGS);
+    meter.check_readings();
+  }
+} // namespace
+
+int main()
+{
+  retries_within_budget();
+  resync_after_garbage();
+  backoff_while_silent();
+  failed_watch_reads_keep_the_sweep();
+  return test_result();
+}
@@ -0,0 +1,63 @@
+#!/usr/bin/env python3
+"""Build and run the host tests of the BL0910 component under AddressSanitizer and UBSan.
+
+Each tests/*_test.cpp is compiled with the component sources against the stand-in ESPHome
+headers in tests/stubs and run on its own. The run fails if any test does not build, fails a
+check or trips a sanitizer.
+
+    python3 tests/run.py                    # every test
+    python3 tests/run.py watch_burst_test
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+from pathlib import Path
+
+HERE = Path(__file__).resolve().parent
+COMPONENT = HERE.parent / "custom_components" / "bl0910"
+BUILD = HERE / "build"
+SOURCES = [COMPONENT / "bl0910.cpp", COMPONENT / "hub.cpp"]
+FLAGS = ["-std=gnu++17", "-O1", "-g", "-pthread", "-fsanitize=address,undefined", "-fno-omit-frame-pointer",
+         "-DESPHOME_LOG_LEVEL=ESPHOME_LOG_LEVEL_WARN"]
+
+
+def build(test, compiler):
+    binary = BUILD / test.stem
+    BUILD.mkdir(exist_ok=True)
+    command = [compiler, *FLAGS, f"-I{HERE / 'stubs'}", f"-I{COMPONENT}", f"-I{HERE}", str(test),
+               *map(str, SOURCES), "-o", str(binary)]
+    subprocess.run(command, check=True)
+    return binary
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("tests", nargs="*", help="test names, default: all")
+    parser.add_argument("--cxx", default=os.environ.get("CXX", "g++"))
+    args = parser.parse_args()
+
+    tests = sorted(HERE.glob("*_test.cpp"))
+    if args.tests:
+        tests = [test for test in tests if test.stem in args.tests]
+    env = dict(os.environ, UBSAN_OPTIONS="halt_on_error=1:print_stacktrace=1")
+    failed = []
+    for test in tests:
+        print(f"== {test.stem}", flush=True)
+        try:
+            result = subprocess.run([str(build(test, args.cxx))], env=env)
+        except subprocess.CalledProcessError:
+            failed.append(test.stem)
+            continue
+        if result.returncode != 0:
+            failed.append(test.stem)
+    if failed:
+        print(f"FAILED: {', '.join(failed)}")
+        return 1
+    print(f"{len(tests)} tests passed")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
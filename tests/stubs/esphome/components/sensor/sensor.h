@@ -0,0 +1,23 @@
+#pragma once
+// Host stand-in for esphome/components/sensor/sensor.h: only what the bl0910 component uses
+#include <string>
+#include <cmath>
+#include "esphome/core/component.h"
+#include "esphome/core/helpers.h"
+namespace esphome { namespace sensor {
+class Sensor {
+ public:
+  explicit Sensor(const std::string &name = "s") : name_(name) {}
+  void publish_state(float v) { state = v; has_state_ = true; publish_count++; }
+  const std::string &get_name() const { return name_; }
+  uint32_t get_object_id_hash() { return fnv1_hash(name_); }
+  uint32_t get_preference_hash() { return fnv1_hash(name_); }
+  bool has_state() const { return has_state_; }
+  float state{NAN};
+  int publish_count{0};
+ protected: std::string name_; bool has_state_{false};
+};
+}}
+#define SUB_SENSOR(name) \
+ protected: sensor::Sensor *name##_sensor_{nullptr}; \
+ public: void set_##name##_sensor(sensor::Sensor *sensor) { this->name##_sensor_ = sensor; }
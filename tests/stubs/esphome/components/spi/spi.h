@@ -0,0 +1,33 @@
+#pragma once
+// Host stand-in for esphome/components/spi/spi.h: only what the bl0910 component uses
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+namespace esphome { namespace spi {
+enum SPIBitOrder { BIT_ORDER_LSB_FIRST, BIT_ORDER_MSB_FIRST };
+enum SPIClockPolarity { CLOCK_POLARITY_LOW, CLOCK_POLARITY_HIGH };
+enum SPIClockPhase { CLOCK_PHASE_LEADING, CLOCK_PHASE_TRAILING };
+enum SPIDataRate : uint32_t { DATA_RATE_1KHZ = 1000, DATA_RATE_200KHZ=200000, DATA_RATE_1MHZ = 1000000, DATA_RATE_2MHZ = 2000000, DATA_RATE_4MHZ = 4000000, DATA_RATE_5MHZ = 5000000, DATA_RATE_8MHZ = 8000000, DATA_RATE_10MHZ=10000000 };
+class SPIComponent {};
+class SPIClient {
+ public:
+  virtual ~SPIClient() = default;
+  virtual void spi_setup() { setup_count++; }
+  virtual void spi_teardown() {}
+  void set_data_rate(uint32_t r) { data_rate_ = r; }
+  void enable() { enabled++; }
+  void disable() {}
+  int setup_count{0}; int enabled{0};
+ protected: uint32_t data_rate_{1000000};
+};
+template<SPIBitOrder B, SPIClockPolarity P, SPIClockPhase H, SPIDataRate R> class SPIDevice : public SPIClient {
+ public:
+  SPIDevice() { this->data_rate_ = R; }
+  void set_spi_parent(SPIComponent *p) {}
+  uint8_t transfer_byte(uint8_t d) { return hook ? hook(d) : 0; }
+  void transfer_array(uint8_t *d, size_t len) { for (size_t i=0;i<len;i++) d[i]=transfer_byte(d[i]); }
+  void write_array(const uint8_t *d, size_t len) { for (size_t i=0;i<len;i++) transfer_byte(d[i]); }
+  void read_array(uint8_t *d, size_t len) { for (size_t i=0;i<len;i++) d[i]=transfer_byte(0); }
+  uint8_t (*hook)(uint8_t){nullptr};
+};
+}}
@@ -0,0 +1,22 @@
+#pragma once
+// Host stand-in for esphome/components/uart/uart.h: only what the bl0910 component uses
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <vector>
+namespace esphome { namespace uart {
+class UARTComponent { public: uint32_t get_baud_rate() const { return 19200; } };
+class UARTDevice {
+ public:
+  void set_uart_parent(UARTComponent *p) { parent_ = p; }
+  void write_byte(uint8_t data) { tx.push_back(data); }
+  void write_array(const uint8_t *data, size_t len) { tx.insert(tx.end(), data, data + len); }
+  bool read_byte(uint8_t *data) { if (rx.empty()) return false; *data = rx.front(); rx.pop_front(); return true; }
+  bool peek_byte(uint8_t *data) { if (rx.empty()) return false; *data = rx.front(); return true; }
+  bool read_array(uint8_t *data, size_t len) { if (rx.size() < len) return false; for (size_t i=0;i<len;i++){data[i]=rx.front(); rx.pop_front();} return true; }
+  int available() { return rx.size(); }
+  void flush() {}
+  std::vector<uint8_t> tx; std::deque<uint8_t> rx;
+ protected: UARTComponent *parent_{nullptr};
+};
+}}
@@ -0,0 +1,3 @@
+#pragma once
+// Host stand-in for esphome/core/application.h: only what the bl0910 component uses
+namespace esphome { class Application { public: void feed_wdt() {} }; inline Application App; }
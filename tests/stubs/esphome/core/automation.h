@@ -0,0 +1,31 @@
+#pragma once
+// Host stand-in for esphome/core/automation.h: only what the bl0910 component uses
+#include <tuple>
+#include <functional>
+#include "esphome/core/helpers.h"
+namespace esphome {
+template<typename T, typename... X> class TemplatableValue {
+ public:
+  TemplatableValue() {}
+  TemplatableValue(T v) : value_(v), has_(true) {}
+  bool has_value() const { return has_; }
+  T value(X... x) const { return value_; }
+ protected: T value_{}; bool has_{false};
+};
+#define TEMPLATABLE_VALUE_(type, name) \
+ protected: TemplatableValue<type, Ts...> name##_{}; \
+ public: template<typename V> void set_##name(V name) { this->name##_ = name; }
+#define TEMPLATABLE_VALUE(type, name) TEMPLATABLE_VALUE_(type, name)
+template<typename... Ts> class Trigger {
+ public:
+  void trigger(Ts... x) { count_++; for (auto &f : fs_) f(x...); }
+  void add(std::function<void(Ts...)> f) { fs_.push_back(f); }
+  int count_{0};
+ protected: std::vector<std::function<void(Ts...)>> fs_;
+};
+template<typename... Ts> class Action {
+ public:
+  virtual ~Action() = default;
+  virtual void play(Ts... x) = 0;
+};
+}
@@ -0,0 +1,34 @@
+#pragma once
+// Host stand-in for esphome/core/component.h: only what the bl0910 component uses
+#include <cstdint>
+#include <string>
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+namespace esphome {
+namespace setup_priority { const float DATA = 600.0f; const float BUS = 1000.0f; const float HARDWARE = 800.0f; const float AFTER_CONNECTION=100.0f; }
+class Component {
+ public:
+  virtual ~Component() = default;
+  virtual void setup() {}
+  virtual void loop() {}
+  virtual void dump_config() {}
+  virtual float get_setup_priority() const { return setup_priority::DATA; }
+  virtual void on_shutdown() {}
+  void mark_failed() { failed_ = true; }
+  bool is_failed() const { return failed_; }
+  void status_set_warning() {} void status_clear_warning() {}
+  void set_timeout(const std::string &, uint32_t, std::function<void()> &&) {}
+  void set_interval(const std::string &, uint32_t, std::function<void()> &&) {}
+ protected:
+  bool failed_{false};
+};
+class PollingComponent : public Component {
+ public:
+  virtual void update() = 0;
+  void set_update_interval(uint32_t v) { update_interval_ = v; }
+  virtual uint32_t get_update_interval() const { return update_interval_; }
+  void stop_poller() {} void start_poller() {}
+ protected:
+  uint32_t update_interval_{10000};
+};
+}
@@ -0,0 +1,2 @@
+#pragma once
+// Host stand-in for esphome/core/datatypes.h: only what the bl0910 component uses
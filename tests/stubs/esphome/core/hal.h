@@ -0,0 +1,11 @@
+#pragma once
+// Host stand-in for esphome/core/hal.h: only what the bl0910 component uses
+#include <cstdint>
+#include <chrono>
+#include <thread>
+namespace esphome {
+inline uint32_t micros() { static auto s = std::chrono::steady_clock::now(); return (uint32_t) std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - s).count(); }
+inline uint32_t millis() { return micros() / 1000; }
+inline void delay(uint32_t ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+inline void delayMicroseconds(uint32_t us) { std::this_thread::sleep_for(std::chrono::microseconds(us)); }
+}
@@ -0,0 +1,25 @@
+#pragma once
+// Host stand-in for esphome/core/helpers.h: only what the bl0910 component uses
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <functional>
+#include <cstdio>
+namespace esphome {
+inline uint32_t fnv1_hash(const std::string &str) { uint32_t h = 2166136261UL; for (char c : str) { h *= 16777619UL; h ^= c; } return h; }
+template<typename T> class Parented { public: Parented() {} void set_parent(T *p) { parent_ = p; } T *get_parent() const { return parent_; } protected: T *parent_{nullptr}; };
+class InterruptLock { public: InterruptLock() {} ~InterruptLock() {} };
+template<typename... X> class CallbackManager;
+template<typename... Ts> class CallbackManager<void(Ts...)> {
+ public:
+  void add(std::function<void(Ts...)> &&cb) { cbs_.push_back(std::move(cb)); }
+  void call(Ts... args) { for (auto &cb : cbs_) cb(args...); }
+  size_t size() const { return cbs_.size(); }
+ protected: std::vector<std::function<void(Ts...)>> cbs_;
+};
+inline std::string format_hex_pretty(const uint8_t *data, size_t len) { std::string s; char b[4]; for (size_t i=0;i<len;i++){snprintf(b,4,"%02X.",data[i]); s+=b;} return s; }
+}
+#include <functional>
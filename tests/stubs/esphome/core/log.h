@@ -0,0 +1,36 @@
+#pragma once
+// Host stand-in for esphome/core/log.h: only what the bl0910 component uses
+#include <cstdio>
+
+#define ESPHOME_LOG_LEVEL_NONE 0
+#define ESPHOME_LOG_LEVEL_ERROR 1
+#define ESPHOME_LOG_LEVEL_WARN 2
+#define ESPHOME_LOG_LEVEL_INFO 3
+#define ESPHOME_LOG_LEVEL_CONFIG 4
+#define ESPHOME_LOG_LEVEL_DEBUG 5
+#define ESPHOME_LOG_LEVEL_VERBOSE 6
+// Set with -DESPHOME_LOG_LEVEL=... like the logger's level; messages above it compile out
+#ifndef ESPHOME_LOG_LEVEL
+#define ESPHOME_LOG_LEVEL ESPHOME_LOG_LEVEL_DEBUG
+#endif
+
+#define ESP_LOG_AT_(level, letter, tag, ...) \
+  do { \
+    if (ESPHOME_LOG_LEVEL >= (level)) \
+    { \
+      printf("[" letter "][%s] ", tag); \
+      printf(__VA_ARGS__); \
+      printf("\n"); \
+    } \
+  } while (0)
+#define ESP_LOGE(tag, ...) ESP_LOG_AT_(ESPHOME_LOG_LEVEL_ERROR, "E", tag, __VA_ARGS__)
+#define ESP_LOGW(tag, ...) ESP_LOG_AT_(ESPHOME_LOG_LEVEL_WARN, "W", tag, __VA_ARGS__)
+#define ESP_LOGI(tag, ...) ESP_LOG_AT_(ESPHOME_LOG_LEVEL_INFO, "I", tag, __VA_ARGS__)
+#define ESP_LOGCONFIG(tag, ...) ESP_LOG_AT_(ESPHOME_LOG_LEVEL_CONFIG, "C", tag, __VA_ARGS__)
+#define ESP_LOGD(tag, ...) ESP_LOG_AT_(ESPHOME_LOG_LEVEL_DEBUG, "D", tag, __VA_ARGS__)
+#define ESP_LOGV(tag, ...) ESP_LOG_AT_(ESPHOME_LOG_LEVEL_VERBOSE, "V", tag, __VA_ARGS__)
+#define ESP_LOGVV(tag, ...) do {} while (0)
+#define LOG_SENSOR(prefix, type, obj) do { if ((obj) != nullptr) ESP_LOGCONFIG(TAG, "%s%s '%s'", prefix, type, (obj)->get_name().c_str()); } while (0)
+#define LOG_UPDATE_INTERVAL(this) ESP_LOGCONFIG(TAG, "  Update Interval: %.1fs", this->get_update_interval() / 1000.0f)
+#define LOG_PIN(prefix, pin) do {} while (0)
+#define YESNO(b) ((b) ? "YES" : "NO")
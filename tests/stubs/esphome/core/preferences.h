@@ -0,0 +1,25 @@
+#pragma once
+// Host stand-in for esphome/core/preferences.h: only what the bl0910 component uses
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <vector>
+namespace esphome {
+struct ESPPreferenceBackendStub { std::map<uint32_t, std::vector<uint8_t>> store; int saves{0}; };
+inline ESPPreferenceBackendStub &pref_store() { static ESPPreferenceBackendStub s; return s; }
+class ESPPreferenceObject {
+ public:
+  ESPPreferenceObject() {}
+  explicit ESPPreferenceObject(uint32_t key) : key_(key), valid_(true) {}
+  template<typename T> bool save(const T *src) { if (!valid_) return false; auto &v = pref_store().store[key_]; v.assign((const uint8_t *) src, (const uint8_t *) src + sizeof(T)); pref_store().saves++; return true; }
+  template<typename T> bool load(T *dest) { if (!valid_) return false; auto it = pref_store().store.find(key_); if (it == pref_store().store.end() || it->second.size() != sizeof(T)) return false; memcpy(dest, it->second.data(), sizeof(T)); return true; }
+ protected: uint32_t key_{0}; bool valid_{false};
+};
+class ESPPreferences {
+ public:
+  template<typename T> ESPPreferenceObject make_preference(uint32_t type, bool in_flash) { return ESPPreferenceObject(type); }
+  template<typename T> ESPPreferenceObject make_preference(uint32_t type) { return ESPPreferenceObject(type); }
+  bool sync() { return true; }
+};
+inline ESPPreferences *global_preferences = new ESPPreferences();
+}
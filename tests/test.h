@@ -0,0 +1,79 @@
+#pragma once
+// Checks for the host tests: a failed check is reported and fails the test at the end.
+#include <cmath>
+#include <cstdio>
+
+#include "esphome/core/component.h"
+#include "bl0910.h"
+
+namespace esphome
+{
+  namespace bl0910
+  {
+    inline int &test_failures()
+    {
+      static int failures = 0;
+      return failures;
+    }
+
+    inline int test_result()
+    {
+      if (test_failures() == 0)
+      {
+        printf("PASS\n");
+      }
+      return test_failures() == 0 ? 0 : 1;
+    }
+
+    // Call loop() the way the main loop does, for duration_us
+    inline void run_loop(Component &component, uint32_t duration_us)
+    {
+      uint32_t start = micros();
+      while (micros() - start < duration_us)
+      {
+        component.loop();
+      }
+    }
+
+    // Start a sweep with update() and call loop() until it is done. Returns false if it is not done
+    // within timeout_us.
+    inline bool run_sweep(BL0910 &chip, uint32_t timeout_us = 1000000)
+    {
+      uint32_t sweeps = chip.get_diagnostics().sweeps;
+      chip.update();
+      uint32_t start = micros();
+      while (chip.get_diagnostics().sweeps == sweeps)
+      {
+        if (micros() - start >= timeout_us)
+        {
+          return false;
+        }
+        chip.loop();
+      }
+      return true;
+    }
+
+  } // namespace bl0910
+} // namespace esphome
+
+#define CHECK(condition) \
+  do \
+  { \
+    if (!(condition)) \
+    { \
+      printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition); \
+      esphome::bl0910::test_failures()++; \
+    } \
+  } while (0)
+
+#define CHECK_NEAR(value, expected, tolerance) \
+  do \
+  { \
+    float actual_ = (value); \
+    if (!(std::fabs(actual_ - (expected)) <= (tolerance))) \
+    { \
+      printf("%s:%d: CHECK_NEAR failed: %s = %g, expected %g\n", __FILE__, __LINE__, #value, actual_, \
+             (double) (expected)); \
+      esphome::bl0910::test_failures()++; \
+    } \
+  } while (0)
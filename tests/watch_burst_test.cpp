@@ -0,0 +1,47 @@
+// Overload watch over SPI in burst mode, with current and power limits on every channel: each
+// burst must stay within one register group. Run under AddressSanitizer by tests/run.py.
+#include "bl0910.h"
+#include "test.h"
+
+using namespace esphome;
+using namespace esphome::bl0910;
+
+int main()
+{
+  BL0910EmulatedSPI meter;
+  EmulatorConfig config{};
+  config.noise_lsb = 0;
+  meter.set_emulator_config(config);
+  meter.set_spi_burst(true);
+  meter.set_watch_interval(1000);
+  sensor::Sensor current[BL0910_CHANNEL_COUNT];
+  sensor::Sensor power[BL0910_CHANNEL_COUNT];
+  for (uint8_t channel = 1; channel <= BL0910_CHANNEL_COUNT; channel++)
+  {
+    meter.set_channel_sensor(channel, ChannelSlot::CURRENT, &current[channel - 1]);
+    meter.set_channel_sensor(channel, ChannelSlot::POWER, &power[channel - 1]);
+    meter.set_overload_limit(channel, ChannelSlot::CURRENT, 16.0f, 1.0f);
+    meter.set_overload_limit(channel, ChannelSlot::POWER, 3500.0f, 200.0f);
+  }
+  uint16_t overcurrent = 0;
+  uint16_t overpower = 0;
+  meter.add_on_overcurrent_callback([&](uint8_t channel, float) { overcurrent |= 1 << channel; });
+  meter.add_on_overpower_callback([&](uint8_t channel, float) { overpower |= 1 << channel; });
+  meter.setup();
+
+  // Channel 7 at 20 A and 230 V: above both limits, the others below
+  meter.get_emulator().set_channel_load(7, 20.0f, 0.9f);
+  for (int update = 0; update < 3; update++)
+  {
+    meter.update();
+    run_loop(meter, 20000);
+  }
+
+  CHECK(overcurrent == 1 << 7);
+  CHECK(overpower == 1 << 7);
+  CHECK(meter.get_diagnostics().checksum_errors == 0);
+  CHECK(meter.get_diagnostics().timeouts == 0);
+  CHECK_NEAR(current[6].state, 20.0f, 0.1f);
+  CHECK_NEAR(current[0].state, 0.5f, 0.01f);
+  return test_result();
+}
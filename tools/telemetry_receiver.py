@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+"""Receive BL0910 telemetry frames over UDP and print them, one line per frame.
+
+The frame format is described in custom_components/bl0910/telemetry.h. Gaps in a chip's
+sequence numbers are reported as lost frames.
+
+    python3 tools/telemetry_receiver.py --port 5555
+"""
+
+import argparse
+import json
+import socket
+import struct
+
+VERSION = 1
+HEADER = struct.Struct("<2sBBIIB")
+ENTRY = struct.Struct("<BB3sf")
+QUANTITIES = [
+    "current",
+    "power",
+    "energy",
+    "power_factor",
+    "apparent_power",
+    "temperature",
+    "frequency",
+    "voltage",
+    "total_power",
+    "total_energy",
+]
+
+
+def decode(data):
+    """Frame as a dict, or None if it is not a whole frame of a known version."""
+    if len(data) < HEADER.size:
+        return None
+    magic, version, chip, sequence, timestamp, count = HEADER.unpack_from(data)
+    if magic != b"BL" or version != VERSION or len(data) != HEADER.size + count * ENTRY.size:
+        return None
+    entries = []
+    for i in range(count):
+        quantity, channel, raw, value = ENTRY.unpack_from(data, HEADER.size + i * ENTRY.size)
+        name = QUANTITIES[quantity] if quantity < len(QUANTITIES) else f"quantity_{quantity}"
+        entries.append({"quantity": name, "channel": channel, "raw": int.from_bytes(raw, "little"), "value": value})
+    return {"chip": chip, "sequence": sequence, "timestamp": timestamp, "entries": entries}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--bind", default="0.0.0.0")
+    parser.add_argument("--port", type=int, default=5555)
+    parser.add_argument("--json", action="store_true", help="print each frame as JSON")
+    args = parser.parse_args()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind((args.bind, args.port))
+    last = {}
+    while True:
+        data, (host, _) = sock.recvfrom(2048)
+        frame = decode(data)
+        if frame is None:
+            print(f"{host}: {len(data)} bytes, not a telemetry frame")
+            continue
+        key = (host, frame["chip"])
+        if key in last and frame["sequence"] != (last[key] + 1) & 0xFFFFFFFF:
+            print(f"{host} chip {frame['chip']}: lost {(frame['sequence'] - last[key] - 1) & 0xFFFFFFFF} frames")
+        last[key] = frame["sequence"]
+        if args.json:
+            print(json.dumps({"host": host, **frame}))
+            continue
+        values = " ".join(
+            f"{e['quantity']}{e['channel'] or ''}={e['value']:.4g}" for e in frame["entries"]
+        )
+        print(f"{host} chip {frame['chip']} #{frame['sequence']} t={frame['timestamp']} {values}")
+
+
+if __name__ == "__main__":
+    main()